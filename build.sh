@@ -1,6 +1,5 @@
 #!/bin/bash
 
-INPUT_DIR="input_files"
 OUTPUT_DIR="output_files"
 
 echo "Creating output directory..."
@@ -9,40 +8,26 @@ mkdir -p $OUTPUT_DIR
 echo ""
 echo "====================== COMPILING ======================"
 
-echo "Compiling EP..."
-g++ -std=c++17 interrupts_wendingsha_janbeyati_EP.cpp -o interrupts_EP
-
-echo "Compiling RR..."
-g++ -std=c++17 interrupts_wendingsha_janbeyati_RR.cpp -o interrupts_RR
-
-echo "Compiling EP_RR..."
-g++ -std=c++17 interrupts_wendingsha_janbeyati_EP_RR.cpp -o interrupts_EP_RR
+# Release build (-O3, link time optimization) of every simulator and tool, see the Makefile
+echo "Compiling with make release..."
+if ! make -j"$(nproc)" release; then
+    echo "Compilation failed"
+    exit 1
+fi
 
 echo "Compilation complete!"
 echo "======================================================="
 echo ""
 
-run_scheduler () {
-    local EXEC="$1"
-    local TAG="$2"
-
-    echo ""
-    echo "====================== Running $TAG ======================"
-
-    for file in $INPUT_DIR/*.txt; do
-        base=$(basename "$file")
-
-        echo "Running $TAG on $base..."
-
-        ./$EXEC "$file"
-
-        cp execution.txt "$OUTPUT_DIR/execution_${TAG}_${base}"
-    done
-}
+echo "====================== RUNNING ======================="
 
-run_scheduler "interrupts_EP" "EP"
-run_scheduler "interrupts_RR" "RR"
-run_scheduler "interrupts_EP_RR" "EP_RR"
+# Every input file under every policy and setting of the golden sets (see the Makefile), all
+# simulations in parallel. This rewrites output_files/, so new inputs get their traces and an
+# intended change of behaviour its new ones; make check compares a build against them instead.
+if ! make goldens; then
+    echo "Simulations failed"
+    exit 1
+fi
 
 echo ""
 echo "====================== ALL DONE ======================="
@@ -18,9 +18,30 @@
 #include<sstream>
 #include<iomanip>
 #include<algorithm>
+#include<map>
+#include<set>
+#include<unordered_map>
+#include<climits>
+#include<cmath>
+#include<cstring>
+#include<cstdint>
+#include<stdexcept>
+#include<atomic>
+#include<thread>
+#include<memory>
+#include<memory_resource>
+#include<chrono>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include<immintrin.h>
+#endif
 
-//An enumeration of states to make assignment easier
-enum states {
+//An enumeration of states to make assignment easier. One byte, so the process store's state
+//column packs 64 processes per cache line.
+enum states : std::uint8_t {
     NEW,
     READY,
     RUNNING,
@@ -45,13 +66,51 @@ struct memory_partition{
     unsigned int    partition_number;
     unsigned int    size;
     int             occupied;
-} memory_paritions[] = {
-    {1, 40, -1},
-    {2, 25, -1},
-    {3, 15, -1},
-    {4, 10, -1},
-    {5, 8, -1},
-    {6, 2, -1}
+};
+
+//How memory is handed out to processes
+enum allocator_modes {
+    FIXED_PARTITIONS,       //the partition table, best fit
+    VARIABLE_PARTITIONS     //one block of the total size, carved per process and coalesced on free
+};
+
+//Which process waiting for memory is admitted first when memory is freed
+enum admission_orders {
+    ADMIT_FCFS,             //in arrival order; a process that does not fit holds back the ones behind it
+    ADMIT_SMALLEST_FIRST,   //smallest process first
+    ADMIT_BEST_FIT          //the process that leaves the least memory unused in its partition or hole
+};
+
+//How ready processes are spread over the CPUs when there is more than one
+enum balancers {
+    BALANCE_PUSH,           //a process that becomes ready goes to the CPU with the fewest processes
+    BALANCE_PULL,           //it goes back to its own CPU; a CPU with nothing to do takes one process
+                            //from the busiest CPU's ready queue
+    BALANCE_STEAL           //like pull, but the idle CPU takes half of the busiest CPU's ready queue
+};
+
+//Ready queue the external priority policies (EP, EP_RR) keep their processes in
+enum ready_queues {
+    READY_HEAP,             //binary heap on the PID, O(log n) push and pop
+    READY_SCAN              //flat array of PIDs, O(n) SIMD argmin per pop (scan_queue)
+};
+
+//Default time slice of the round robin policies
+const unsigned int QUANTUM = 100;
+
+//Settings a simulation is started with. Chosen once at startup (see parse_config_arg).
+struct simulation_config {
+    std::vector<unsigned int>   partition_sizes = {40, 25, 15, 10, 8, 2};  //partition 1 first
+    allocator_modes             allocator = FIXED_PARTITIONS;
+    admission_orders            admission = ADMIT_FCFS;
+    unsigned int                quantum = QUANTUM;      //RR and EP_RR time slice
+    std::vector<unsigned int>   mlfq_quanta;            //MLFQ slice per level, top level first;
+                                                        //empty means quantum, 2 x quantum, 4 x quantum
+    unsigned int                mlfq_boost = 1000;      //MLFQ: move everyone to the top level this often (0: never)
+    unsigned int                cpus = 1;               //number of CPUs, each with its own ready queue
+    balancers                   balancer = BALANCE_PUSH;
+    bool                        affinity = false;       //pin each process to CPU PID % cpus (no balancing)
+    ready_queues                ready_queue = READY_HEAP;   //EP and EP_RR ready queue
 };
 
 struct PCB{
@@ -67,6 +126,467 @@ struct PCB{
     unsigned int    io_duration;
 };
 
+//------------------------------------SIMD KERNELS----------------------------------------------------
+//Position of the minimum over a contiguous array of keys, for ready queues that scan instead of
+//keeping a heap (scan_queue). The kernel has a scalar version and, on x86, SSE4.1 and AVX2 versions
+//compiled with a target attribute; argmin_i32() picks the best one the CPU supports the first time
+//it is called. All versions return the same result: on ties the first position.
+
+enum simd_levels {SIMD_SCALAR, SIMD_SSE41, SIMD_AVX2};
+
+simd_levels detect_simd_level() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        return SIMD_AVX2;
+    }
+    if(__builtin_cpu_supports("sse4.1")) {
+        return SIMD_SSE41;
+    }
+#endif
+    return SIMD_SCALAR;
+}
+
+//Index of the smallest key, n if n == 0
+std::size_t argmin_i32_scalar(const std::int32_t *keys, std::size_t n) {
+    std::size_t best = 0;
+    for(std::size_t i = 1; i < n; i++) {
+        if(keys[i] < keys[best]) {
+            best = i;
+        }
+    }
+    return n == 0 ? 0 : best;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+//Lanes keep their own minimum and its index; a lane only takes a strictly smaller key, so each
+//lane holds its first minimum and the smallest index among the lanes at the end is the first overall.
+__attribute__((target("sse4.1")))
+std::size_t argmin_i32_sse41(const std::int32_t *keys, std::size_t n) {
+    if(n < 8) {
+        return argmin_i32_scalar(keys, n);
+    }
+    __m128i best = _mm_loadu_si128((const __m128i *)keys);
+    __m128i best_index = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i index = best_index;
+    const __m128i step = _mm_set1_epi32(4);
+    std::size_t i = 4;
+    for(; i + 4 <= n; i += 4) {
+        index = _mm_add_epi32(index, step);
+        __m128i v = _mm_loadu_si128((const __m128i *)(keys + i));
+        __m128i smaller = _mm_cmpgt_epi32(best, v);
+        best = _mm_blendv_epi8(best, v, smaller);
+        best_index = _mm_blendv_epi8(best_index, index, smaller);
+    }
+    alignas(16) std::int32_t lane_keys[4];
+    alignas(16) std::int32_t lane_index[4];
+    _mm_store_si128((__m128i *)lane_keys, best);
+    _mm_store_si128((__m128i *)lane_index, best_index);
+    std::size_t result = lane_index[0];
+    for(int lane = 1; lane < 4; lane++) {
+        if(lane_keys[lane] < keys[result] || (lane_keys[lane] == keys[result] && (std::size_t)lane_index[lane] < result)) {
+            result = lane_index[lane];
+        }
+    }
+    for(; i < n; i++) {
+        if(keys[i] < keys[result]) {
+            result = i;
+        }
+    }
+    return result;
+}
+
+__attribute__((target("avx2")))
+std::size_t argmin_i32_avx2(const std::int32_t *keys, std::size_t n) {
+    if(n < 16) {
+        return argmin_i32_scalar(keys, n);
+    }
+    __m256i best = _mm256_loadu_si256((const __m256i *)keys);
+    __m256i best_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i index = best_index;
+    const __m256i step = _mm256_set1_epi32(8);
+    std::size_t i = 8;
+    for(; i + 8 <= n; i += 8) {
+        index = _mm256_add_epi32(index, step);
+        __m256i v = _mm256_loadu_si256((const __m256i *)(keys + i));
+        __m256i smaller = _mm256_cmpgt_epi32(best, v);
+        best = _mm256_blendv_epi8(best, v, smaller);
+        best_index = _mm256_blendv_epi8(best_index, index, smaller);
+    }
+    alignas(32) std::int32_t lane_keys[8];
+    alignas(32) std::int32_t lane_index[8];
+    _mm256_store_si256((__m256i *)lane_keys, best);
+    _mm256_store_si256((__m256i *)lane_index, best_index);
+    std::size_t result = lane_index[0];
+    for(int lane = 1; lane < 8; lane++) {
+        if(lane_keys[lane] < keys[result] || (lane_keys[lane] == keys[result] && (std::size_t)lane_index[lane] < result)) {
+            result = lane_index[lane];
+        }
+    }
+    for(; i < n; i++) {
+        if(keys[i] < keys[result]) {
+            result = i;
+        }
+    }
+    return result;
+}
+
+#endif
+
+typedef std::size_t (*argmin_i32_kernel)(const std::int32_t *, std::size_t);
+
+//The kernel for level; a level the build has no kernel for falls back to scalar
+argmin_i32_kernel argmin_i32_for(simd_levels level) {
+#if defined(__x86_64__) || defined(__i386__)
+    if(level == SIMD_AVX2) {
+        return argmin_i32_avx2;
+    }
+    if(level == SIMD_SSE41) {
+        return argmin_i32_sse41;
+    }
+#endif
+    (void)level;
+    return argmin_i32_scalar;
+}
+
+std::size_t argmin_i32(const std::int32_t *keys, std::size_t n) {
+    static const argmin_i32_kernel kernel = argmin_i32_for(detect_simd_level());
+    return kernel(keys, n);
+}
+
+//------------------------------------RUN ARENA-------------------------------------------------------
+//Everything a simulation allocates for itself (the job table, ready queues, I/O events, admission
+//queue, memory allocator maps) comes from one arena per run_simulation() call and is given back in
+//one go when the run ends. The containers are std::pmr ones; outside a run they use the default
+//(new/delete) resource as before. The arena is three resources stacked:
+//  pool    unsynchronized_pool_resource: recycles freed blocks, so the tree nodes that come and go
+//          with every memory allocation and release stop reaching the heap
+//  buffer  monotonic_buffer_resource under the pool: carves memory out of big blocks, sized from
+//          the number of processes, and frees nothing before the end of the run
+//  heap    counting_resource under both: the only calls that reach new/delete, counted so the
+//          metrics show how many happened once the event loop was running (normally none)
+
+//Forwards to upstream and counts the allocations that go through
+struct counting_resource : std::pmr::memory_resource {
+    std::pmr::memory_resource   *upstream;
+    std::size_t                 allocations = 0;
+    std::size_t                 bytes = 0;
+
+    explicit counting_resource(std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+        : upstream(upstream) {}
+
+    void* do_allocate(std::size_t n, std::size_t alignment) override {
+        allocations++;
+        bytes += n;
+        return upstream->allocate(n, alignment);
+    }
+
+    void do_deallocate(void *p, std::size_t n, std::size_t alignment) override {
+        upstream->deallocate(p, n, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+//Heap use of one run
+struct allocation_stats {
+    std::size_t     heap_blocks = 0;        //blocks the arena took from the heap
+    std::size_t     heap_bytes = 0;
+    std::size_t     loop_heap_blocks = 0;   //of those, taken while the event loop was running
+};
+
+//First arena block: enough per process for its job table columns plus ready queue, I/O event and
+//admission slots, with room for those queues to double
+const std::size_t ARENA_BYTES_PER_PROCESS = 192;
+const std::size_t ARENA_MIN_BYTES = 1 << 16;
+
+struct run_arena {
+    counting_resource                       heap;
+    std::pmr::monotonic_buffer_resource     buffer;
+    std::pmr::unsynchronized_pool_resource  pool;
+    std::size_t                             loop_start = 0;     //heap.allocations when the loop started
+
+    explicit run_arena(std::size_t processes)
+        : buffer(std::max(ARENA_MIN_BYTES, processes * ARENA_BYTES_PER_PROCESS), &heap), pool(&buffer) {}
+    run_arena(const run_arena &) = delete;
+    run_arena& operator=(const run_arena &) = delete;
+
+    std::pmr::memory_resource* resource() { return &pool; }
+
+    void start_loop() { loop_start = heap.allocations; }
+
+    allocation_stats stats() const {
+        return {heap.allocations, heap.bytes, heap.allocations - loop_start};
+    }
+};
+
+//------------------------------------READY QUEUES----------------------------------------------------
+//All ready queues share the same interface: push(), pop(), top(), empty() and size(),
+//so a simulator can swap its dispatch order by changing the queue type. Each takes an optional
+//memory resource to allocate from (the run's arena in run_simulation).
+
+//FIFO ready queue backed by a ring buffer (power-of-two capacity). push/pop are O(1).
+template<typename T>
+struct fifo_queue {
+    std::pmr::vector<T> buffer;
+    std::size_t         head = 0;
+    std::size_t         count = 0;
+
+    fifo_queue() = default;
+    explicit fifo_queue(std::pmr::memory_resource *resource) : buffer(resource) {}
+
+    bool empty() const { return count == 0; }
+    std::size_t size() const { return count; }
+    const T& top() const { return buffer[head]; }
+
+    void push(const T &item) {
+        if(count == buffer.size()) {
+            grow();
+        }
+        buffer[(head + count) & (buffer.size() - 1)] = item;
+        count++;
+    }
+
+    T pop() {
+        T item = buffer[head];
+        head = (head + 1) & (buffer.size() - 1);
+        count--;
+        return item;
+    }
+
+    //Double the capacity and unwrap the elements to the front of the new buffer
+    void grow() {
+        std::pmr::vector<T> bigger(buffer.empty() ? 16 : buffer.size() * 2, buffer.get_allocator());
+        for(std::size_t i = 0; i < count; i++) {
+            bigger[i] = buffer[(head + i) & (buffer.size() - 1)];
+        }
+        buffer.swap(bigger);
+        head = 0;
+    }
+};
+
+//Priority ready queue backed by a binary min-heap; top() is the element that Compare orders first.
+//push/pop are O(log n), top is O(1).
+template<typename T, typename Compare>
+struct heap_queue {
+    std::pmr::vector<T> heap;
+    Compare             less;
+
+    heap_queue() = default;
+    explicit heap_queue(Compare less, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : heap(resource), less(less) {}
+
+    bool empty() const { return heap.empty(); }
+    std::size_t size() const { return heap.size(); }
+    const T& top() const { return heap.front(); }
+
+    void push(const T &item) {
+        heap.push_back(item);
+        std::push_heap(heap.begin(), heap.end(), greater_than());
+    }
+
+    T pop() {
+        std::pop_heap(heap.begin(), heap.end(), greater_than());
+        T item = heap.back();
+        heap.pop_back();
+        return item;
+    }
+
+    //std heap algorithms build a max-heap, so invert the ordering
+    auto greater_than() const {
+        return [this](const T &a, const T &b){ return less(b, a); };
+    }
+};
+
+//Priority ready queue that keeps its keys in one contiguous array and finds the smallest with
+//argmin_i32(). push is O(1), top and pop are an O(n) SIMD scan. Key(item) gives the int key of
+//an item when it is pushed. On equal keys the earlier position wins; pop() moves the last item
+//into the hole, so positions are not arrival order. EP and EP_RR use it with --ready-queue scan.
+template<typename T, typename Key>
+struct scan_queue {
+    std::pmr::vector<T>             items;
+    std::pmr::vector<std::int32_t>  keys;
+    Key                             key;
+
+    scan_queue() = default;
+    explicit scan_queue(Key key, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : items(resource), keys(resource), key(key) {}
+
+    bool empty() const { return items.empty(); }
+    std::size_t size() const { return items.size(); }
+    const T& top() const { return items[argmin_i32(keys.data(), keys.size())]; }
+
+    bool less(const T &a, const T &b) const { return key(a) < key(b); }
+
+    void push(const T &item) {
+        items.push_back(item);
+        keys.push_back(key(item));
+    }
+
+    T pop() {
+        std::size_t best = argmin_i32(keys.data(), keys.size());
+        T item = items[best];
+        items[best] = items.back();
+        keys[best] = keys.back();
+        items.pop_back();
+        keys.pop_back();
+        return item;
+    }
+};
+
+//------------------------------------JOB TABLE-------------------------------------------------------
+//Every process of a simulation lives in one job table for the whole run. A process is referred
+//to by its slot in that table, so the ready, wait and running structures only hold slots and
+//there is never a second copy of a process to keep in sync.
+//
+//The table is stored by column (structure of arrays): a scan over PIDs or states reads one
+//dense array instead of pulling whole PCBs through the cache, and the compiler can vectorize it.
+//A PCB is only put together (view()) to print a process.
+
+//Slot value used when the CPU has no process
+const std::size_t NO_PROCESS = (std::size_t)-1;
+
+struct process_store {
+    std::pmr::memory_resource       *resource;          //where the columns, and the run's queues, allocate
+    std::pmr::vector<int>           PID;                //also the external priority, smaller is higher
+    std::pmr::vector<unsigned int>  size;
+    std::pmr::vector<unsigned int>  arrival_time;
+    std::pmr::vector<int>           start_time;
+    std::pmr::vector<unsigned int>  processing_time;
+    std::pmr::vector<unsigned int>  remaining_time;
+    std::pmr::vector<int>           partition_number;
+    std::pmr::vector<states>        state;
+    std::pmr::vector<unsigned int>  io_freq;            //counts down to the next I/O
+    std::pmr::vector<unsigned int>  io_period;          //io_freq as read from the input, restored after each I/O
+    std::pmr::vector<unsigned int>  io_duration;
+
+    //One slot per process, in the order given
+    explicit process_store(const std::vector<PCB> &processes,
+                           std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : resource(resource), PID(resource), size(resource), arrival_time(resource), start_time(resource),
+          processing_time(resource), remaining_time(resource), partition_number(resource), state(resource),
+          io_freq(resource), io_period(resource), io_duration(resource) {
+        std::size_t n = processes.size();
+        PID.reserve(n); size.reserve(n); arrival_time.reserve(n); start_time.reserve(n);
+        processing_time.reserve(n); remaining_time.reserve(n); partition_number.reserve(n);
+        state.reserve(n); io_freq.reserve(n); io_period.reserve(n); io_duration.reserve(n);
+        for(const auto &p : processes) {
+            PID.push_back(p.PID);
+            size.push_back(p.size);
+            arrival_time.push_back(p.arrival_time);
+            start_time.push_back(p.start_time);
+            processing_time.push_back(p.processing_time);
+            remaining_time.push_back(p.remaining_time);
+            partition_number.push_back(p.partition_number);
+            state.push_back(p.state);
+            io_freq.push_back(p.io_freq);
+            io_period.push_back(p.io_freq);
+            io_duration.push_back(p.io_duration);
+        }
+    }
+
+    std::size_t count() const {
+        return PID.size();
+    }
+
+    //The process in slot as a PCB (a copy, for print_PCB)
+    PCB view(std::size_t slot) const {
+        PCB p;
+        p.PID = PID[slot];
+        p.size = size[slot];
+        p.arrival_time = arrival_time[slot];
+        p.start_time = start_time[slot];
+        p.processing_time = processing_time[slot];
+        p.remaining_time = remaining_time[slot];
+        p.partition_number = partition_number[slot];
+        p.state = state[slot];
+        p.io_freq = io_freq[slot];
+        p.io_duration = io_duration[slot];
+        return p;
+    }
+
+    //PCB views of every process in state
+    std::vector<PCB> views_in_state(states wanted) const {
+        std::vector<PCB> result;
+        for(std::size_t slot = 0; slot < count(); slot++) {
+            if(state[slot] == wanted) {
+                result.push_back(view(slot));
+            }
+        }
+        return result;
+    }
+};
+
+//External priority: the smaller the PID, the higher the priority
+struct lower_PID_first {
+    const std::pmr::vector<int> *PID;
+
+    bool operator()(std::size_t a, std::size_t b) const {
+        return (*PID)[a] < (*PID)[b];
+    }
+};
+
+//Same priority as a scan_queue key
+struct PID_key {
+    const std::pmr::vector<int> *PID;
+
+    std::int32_t operator()(std::size_t slot) const {
+        return (*PID)[slot];
+    }
+};
+
+//------------------------------------I/O EVENT QUEUE-------------------------------------------------
+//Pending I/O completions, ordered by finish time. Completions that finish at the same time
+//come out in the order they were issued, which is the order the old wait queue scan used.
+
+struct io_event {
+    unsigned int    finish_time;
+    unsigned long   sequence;
+    std::size_t     slot;
+};
+
+struct earlier_io_event {
+    bool operator()(const io_event &a, const io_event &b) const {
+        if(a.finish_time != b.finish_time) {
+            return a.finish_time < b.finish_time;
+        }
+        return a.sequence < b.sequence;
+    }
+};
+
+struct io_event_queue {
+    heap_queue<io_event, earlier_io_event>  events;
+    unsigned long                           issued = 0;
+
+    explicit io_event_queue(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : events({}, resource) {}
+
+    bool empty() const { return events.empty(); }
+    std::size_t size() const { return events.size(); }
+
+    //Block the process in slot until finish_time
+    void push(unsigned int finish_time, std::size_t slot) {
+        events.push({finish_time, issued++, slot});
+    }
+
+    //Time of the earliest completion, or (unsigned int)-1 when nothing is waiting
+    unsigned int next_time() const {
+        return events.empty() ? (unsigned int)-1 : events.top().finish_time;
+    }
+
+    //True if a completion is due at current_time; pop() it to get the slot
+    bool due(unsigned int current_time) const {
+        return !events.empty() && events.top().finish_time == current_time;
+    }
+
+    std::size_t pop() {
+        return events.pop().slot;
+    }
+};
+
 //------------------------------------HELPER FUNCTIONS FOR THE SIMULATOR------------------------------
 // Following function was taken from stackoverflow; helper function for splitting strings
 std::vector<std::string> split_delim(std::string input, std::string delim) {
@@ -144,9 +664,10 @@ std::string print_PCB(PCB _PCB) {
     return print_PCB(temp);
 }
 
-std::string print_exec_header() {
+//cpu_column adds the CPU column of multi-CPU simulations
+std::string print_exec_header(bool cpu_column = false) {
 
-    const int tableWidth = 49;
+    const int tableWidth = cpu_column ? 55 : 49;
 
     std::stringstream buffer;
     
@@ -162,7 +683,11 @@ std::string print_exec_header() {
             << std::setfill(' ') << std::setw(10) << "Old State"
             << std::setw(2) << "|"
             << std::setfill(' ') << std::setw(10) << "New State"
-            << std::setw(2) << "|" << std::endl;
+            << std::setw(2) << "|";
+    if (cpu_column) {
+        buffer << std::setw(4) << "CPU" << std::setw(2) << "|";
+    }
+    buffer  << std::endl;
     
     // Print separator
     buffer << "+" << std::setfill('-') << std::setw(tableWidth) << "+" << std::endl;
@@ -173,8 +698,6 @@ std::string print_exec_header() {
 
 std::string print_exec_status(unsigned int current_time, int PID, states old_state, states new_state) {
 
-    const int tableWidth = 49;
-
     std::stringstream buffer;
 
     buffer  << "|"
@@ -190,8 +713,8 @@ std::string print_exec_status(unsigned int current_time, int PID, states old_sta
     return buffer.str();
 }
 
-std::string print_exec_footer() {
-    const int tableWidth = 49;
+std::string print_exec_footer(bool cpu_column = false) {
+    const int tableWidth = cpu_column ? 55 : 49;
     std::stringstream buffer;
 
     // Print bottom border
@@ -200,119 +723,2488 @@ std::string print_exec_footer() {
     return buffer.str();
 }
 
-//Synchronize the process in the process queue
-void sync_queue(std::vector<PCB> &process_queue, PCB _process) {
-    for(auto &process : process_queue) {
-        if(process.PID == _process.PID) {
-            process = _process;
+//------------------------------------FILE INPUT------------------------------------------------------
+
+//A whole file memory mapped read-only. data is nullptr for an empty file.
+struct mapped_file {
+    const char     *data = nullptr;
+    std::size_t     length = 0;
+
+    mapped_file() = default;
+    mapped_file(const mapped_file &) = delete;
+    mapped_file& operator=(const mapped_file &) = delete;
+    ~mapped_file() { close(); }
+
+    //Map filename; on failure error says why
+    bool open(const char *filename, std::string &error) {
+        close();
+        int fd = ::open(filename, O_RDONLY);
+        if(fd < 0) {
+            error = std::string("Unable to open file: ") + filename;
+            return false;
+        }
+        struct stat info;
+        if(fstat(fd, &info) != 0) {
+            ::close(fd);
+            error = std::string("Unable to read file: ") + filename;
+            return false;
+        }
+        if(info.st_size > 0) {
+            void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(mapped == MAP_FAILED) {
+                ::close(fd);
+                error = std::string("Unable to map file: ") + filename;
+                return false;
+            }
+            madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+            data = (const char *)mapped;
+            length = info.st_size;
+        }
+        ::close(fd);
+        return true;
+    }
+
+    void close() {
+        if(data != nullptr) {
+            munmap((void *)data, length);
+        }
+        data = nullptr;
+        length = 0;
+    }
+};
+
+//Parse the input file straight out of the mapped pages and append one PCB per line to processes.
+//Each line is "PID, size, arrival time, processing time, io frequency, io duration". Spaces and
+//tabs around the commas, blank lines and Windows line endings are accepted. Only the PID may be
+//negative. On failure error is "file:line:column: message" and processes is left as it was.
+bool parse_input_file(const char *filename, std::vector<PCB> &processes, std::string &error) {
+    mapped_file input;
+    if(!input.open(filename, error)) {
+        return false;
+    }
+
+    const char *p = input.data;
+    const char *end = p + input.length;
+    const char *line_start = p;
+    std::size_t line = 1;
+    const std::size_t first_new = processes.size();
+
+    auto fail = [&](const char *at, const char *message) {
+        error = std::string(filename) + ":" + std::to_string(line) + ":" +
+                std::to_string(at - line_start + 1) + ": " + message;
+        processes.resize(first_new);
+        return false;
+    };
+    auto skip_blanks = [&]() {
+        while(p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+            p++;
+        }
+    };
+
+    //about 16 bytes per line in practice; saves most of the regrowth on big inputs
+    processes.reserve(first_new + input.length / 16);
+
+    while(p < end) {
+        skip_blanks();
+        if(p == end) {
+            break;
+        }
+        if(*p == '\n') {
+            p++;
+            line++;
+            line_start = p;
+            continue;
+        }
+
+        long long fields[6];
+        for(int f = 0; f < 6; f++) {
+            if(f > 0) {
+                skip_blanks();
+                if(p == end || *p != ',') {
+                    return fail(p, "expected ','");
+                }
+                p++;
+            }
+            skip_blanks();
+
+            bool negative = false;
+            if(f == 0 && p < end && *p == '-') {
+                negative = true;
+                p++;
+            }
+            if(p == end || *p < '0' || *p > '9') {
+                return fail(p, "expected a number");
+            }
+
+            const char *number = p;
+            long long value = 0;
+            while(p < end && *p >= '0' && *p <= '9') {
+                value = value * 10 + (*p - '0');
+                if(value > 2147483647LL) {
+                    return fail(number, "number out of range");
+                }
+                p++;
+            }
+            fields[f] = negative ? -value : value;
+        }
+
+        skip_blanks();
+        if(p < end && *p != '\n') {
+            return fail(p, "expected end of line after 6 fields");
         }
+
+        PCB process;
+        process.PID = (int)fields[0];
+        process.size = fields[1];
+        process.arrival_time = fields[2];
+        process.processing_time = fields[3];
+        process.remaining_time = fields[3];
+        process.io_freq = fields[4];
+        process.io_duration = fields[5];
+        process.start_time = -1;
+        process.partition_number = -1;
+        process.state = NOT_ASSIGNED;
+        processes.push_back(process);
     }
+
+    return true;
 }
 
-//Writes a string to a file
-void write_output(std::string execution, const char* filename) {
-    std::ofstream output_file(filename);
+//------------------------------------WORKLOAD GENERATOR----------------------------------------------
+//Synthetic input files for benchmarks. Every field is drawn from its own distribution with one
+//seeded std::mt19937_64, so a spec and a seed always give the same file. The samples are computed
+//here instead of with the std:: distributions, whose output differs between standard libraries.
+
+enum distribution_kinds {CONSTANT, UNIFORM, EXPONENTIAL, NORMAL};
+
+//CONSTANT a; UNIFORM integers in [a, b]; EXPONENTIAL with mean a; NORMAL with mean a and deviation b.
+//Samples are rounded and clamped to [0, INT_MAX].
+struct distribution {
+    distribution_kinds  kind = CONSTANT;
+    double              a = 0;
+    double              b = 0;
 
-    if (output_file.is_open()) {
-        output_file << execution;
-        output_file.close();  // Close the file when done
-        std::cout << "File content overwritten successfully." << std::endl;
+    unsigned int sample(std::mt19937_64 &rng) const {
+        double value = a;
+        if(kind == UNIFORM) {
+            unsigned long long low = (unsigned long long)std::max(0.0, a);
+            unsigned long long high = (unsigned long long)std::max(a, b);
+            return (unsigned int)std::min<unsigned long long>(low + rng() % (high - low + 1), INT_MAX);
+        } else if(kind == EXPONENTIAL) {
+            value = -a * std::log(1 - unit(rng));
+        } else if(kind == NORMAL) {
+            //Box-Muller
+            double u1 = unit(rng);
+            double u2 = unit(rng);
+            value = a + b * std::sqrt(-2 * std::log(1 - u1)) * std::cos(2 * M_PI * u2);
+        }
+        return (unsigned int)std::min<double>(std::max(0.0, std::round(value)), INT_MAX);
+    }
+
+    //Uniform in [0, 1) from the top 53 bits
+    static double unit(std::mt19937_64 &rng) {
+        return (rng() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+//Parses "const:A", "uniform:A:B", "exp:MEAN" or "normal:MEAN:DEVIATION"
+bool parse_distribution(const std::string &text, distribution &result, std::string &error) {
+    std::vector<std::string> parts = split_delim(text, ":");
+    const std::string &kind = parts[0];
+    std::size_t expected = 0;
+    if(kind == "const") {
+        result.kind = CONSTANT;
+        expected = 2;
+    } else if(kind == "uniform") {
+        result.kind = UNIFORM;
+        expected = 3;
+    } else if(kind == "exp") {
+        result.kind = EXPONENTIAL;
+        expected = 2;
+    } else if(kind == "normal") {
+        result.kind = NORMAL;
+        expected = 3;
     } else {
-        std::cerr << "Error opening file!" << std::endl;
+        error = "unknown distribution \"" + text + "\" (const:A, uniform:A:B, exp:MEAN or normal:MEAN:DEVIATION)";
+        return false;
+    }
+    if(parts.size() != expected) {
+        error = "wrong number of parameters in \"" + text + "\"";
+        return false;
+    }
+    double values[2] = {0, 0};
+    for(std::size_t i = 1; i < parts.size(); i++) {
+        char *end = nullptr;
+        values[i - 1] = std::strtod(parts[i].c_str(), &end);
+        if(parts[i].empty() || *end != '\0' || values[i - 1] < 0) {
+            error = "bad parameter \"" + parts[i] + "\" in \"" + text + "\"";
+            return false;
+        }
+    }
+    result.a = values[0];
+    result.b = values[1];
+    if(result.kind == UNIFORM && result.b < result.a) {
+        error = "empty range in \"" + text + "\"";
+        return false;
+    }
+    return true;
+}
+
+struct workload_spec {
+    std::size_t         processes = 1000;
+    std::uint64_t       seed = 1;
+    distribution        interarrival = {EXPONENTIAL, 5, 0};     //time between two arrivals
+    distribution        burst = {UNIFORM, 1, 200};              //processing time, at least 1
+    distribution        io_freq = {UNIFORM, 0, 50};             //0 means the process never does I/O
+    distribution        io_duration = {UNIFORM, 1, 20};
+    distribution        size = {UNIFORM, 1, 40};                //fits the biggest default partition
+};
+
+//PIDs 1..processes in arrival order
+std::vector<PCB> generate_workload(const workload_spec &spec) {
+    std::mt19937_64 rng(spec.seed);
+    std::vector<PCB> processes;
+    processes.reserve(spec.processes);
+
+    unsigned long long arrival_time = 0;
+    for(std::size_t i = 0; i < spec.processes; i++) {
+        if(i > 0) {
+            arrival_time = std::min<unsigned long long>(arrival_time + spec.interarrival.sample(rng), INT_MAX);
+        }
+        PCB process;
+        process.PID = (int)std::min<std::size_t>(i + 1, INT_MAX);
+        process.size = spec.size.sample(rng);
+        process.arrival_time = (unsigned int)arrival_time;
+        process.processing_time = std::max(1u, spec.burst.sample(rng));
+        process.remaining_time = process.processing_time;
+        process.io_freq = spec.io_freq.sample(rng);
+        process.io_duration = spec.io_duration.sample(rng);
+        process.start_time = -1;
+        process.partition_number = -1;
+        process.state = NOT_ASSIGNED;
+        processes.push_back(process);
     }
+    return processes;
+}
 
-    std::cout << "Output generated in " << filename << ".txt" << std::endl;
+//Write processes in the input file format parse_input_file reads
+bool write_workload(const std::vector<PCB> &processes, const char *filename) {
+    std::ofstream out(filename);
+    if(!out.is_open()) {
+        return false;
+    }
+    for(const auto &p : processes) {
+        out << p.PID << ", " << p.size << ", " << p.arrival_time << ", " << p.processing_time << ", "
+            << p.io_freq << ", " << p.io_duration << '\n';
+    }
+    out.close();
+    return !out.fail();
 }
 
-//--------------------------------------------FUNCTIONS FOR THE "OS"-------------------------------------
+//------------------------------------TRACE OUTPUT----------------------------------------------------
+//Streams the execution table to a file while the simulation runs. Rows are formatted by hand
+//into a fixed buffer that is written out whenever it fills up, so memory use does not grow
+//with the length of the trace. The rows are byte for byte what print_exec_status() produces.
+//
+//In binary mode the same transitions are written as fixed-size records instead of table rows:
+//an 8 byte file header ("SYSCTRC" + version), then one TRACE_RECORD_SIZE record per transition
+//holding the time (u32), PID (i32), old state (u8) and new state (u8), little endian.
+//interrupts_trace2txt turns such a file back into the text table.
+//
+//Simulations with more than one CPU add a CPU column to the table; their binary traces are
+//version 2, whose records end with the CPU (u8).
+//
+//Pipelined mode (start_pipeline) splits the work over two threads: the simulation only sends each
+//transition as a small trace_event over a lock-free channel, and a formatting thread turns the
+//events into rows and writes them. Events are consumed in the order they were sent, so the file
+//is the same as in the single thread mode.
 
-//Assign memory partition to program
-bool assign_memory(PCB &program) {
-    int size_to_fit = program.size;
-    int available_size = 0;
+const std::size_t TRACE_BUFFER_SIZE = 1 << 16;
+const std::size_t TRACE_CHANNEL_CAPACITY = 1 << 16;     //events in flight between the two threads
+const std::size_t TRACE_RECORD_SIZE = 10;
+const std::size_t TRACE_RECORD_SIZE_CPU = 11;
+const char TRACE_MAGIC[8] = {'S', 'Y', 'S', 'C', 'T', 'R', 'C', 1};
+const char TRACE_MAGIC_CPU[8] = {'S', 'Y', 'S', 'C', 'T', 'R', 'C', 2};
 
-    for(int i = 5; i >= 0; i--) {
-        available_size = memory_paritions[i].size;
+//Compares a trace, as it is produced, against a stored one (the golden traces in output_files/).
+//The stored file is memory mapped and read front to back alongside the trace writer's buffer, so
+//neither trace is ever held whole. Only the first difference is kept, as a line number and the
+//two rows that differ.
+struct trace_comparer {
+    mapped_file     expected;
+    std::size_t     matched = 0;        //bytes equal so far
+    std::size_t     line = 1;           //line of the next byte
+    std::string     line_so_far;        //produced bytes since the last newline
+    bool            diverged = false;
+    bool            row_complete = false;
+    std::string     actual_row;         //produced row at the first difference
 
-        if(size_to_fit <= available_size && memory_paritions[i].occupied == -1) {
-            memory_paritions[i].occupied = program.PID;
-            program.partition_number = memory_paritions[i].partition_number;
-            return true;
+    bool open(const char *filename, std::string &error) {
+        return expected.open(filename, error);
+    }
+
+    //Next n bytes of the produced trace
+    void check(const char *data, std::size_t n) {
+        if(diverged) {
+            collect_row(data, n);
+            return;
+        }
+
+        std::size_t available = std::min(n, expected.length - matched);
+        std::size_t same = available;
+        if(std::memcmp(data, expected.data + matched, available) != 0) {
+            same = std::mismatch(data, data + available, expected.data + matched).first - data;
+        }
+
+        //keep the line count and the start of the current row up to the matching part
+        const char *last_newline = nullptr;
+        for(const char *c = (const char *)std::memchr(data, '\n', same); c != nullptr;
+            c = (const char *)std::memchr(c + 1, '\n', data + same - c - 1)) {
+            line++;
+            last_newline = c;
+        }
+        if(last_newline != nullptr) {
+            line_so_far.assign(last_newline + 1, data + same);
+        } else {
+            line_so_far.append(data, same);
+        }
+        matched += same;
+
+        if(same < n) {
+            diverged = true;
+            actual_row = line_so_far;
+            collect_row(data + same, n - same);
         }
     }
 
-    return false;
-}
+    //Add produced bytes to actual_row until it reaches the end of its line
+    void collect_row(const char *data, std::size_t n) {
+        if(row_complete) {
+            return;
+        }
+        const char *newline = (const char *)std::memchr(data, '\n', n);
+        actual_row.append(data, newline != nullptr ? newline - data : n);
+        row_complete = (newline != nullptr);
+    }
 
-//Free a memory partition
-bool free_memory(PCB &program){
-    for(int i = 5; i >= 0; i--) {
-        if(program.PID == memory_paritions[i].occupied) {
-            memory_paritions[i].occupied = -1;
-            program.partition_number = -1;
+    //Call once the whole trace went through check(). Returns true if it equals the stored one,
+    //otherwise report describes the first difference.
+    bool finish(std::string &report) {
+        if(!diverged && matched == expected.length) {
             return true;
         }
+        std::size_t row_start = matched - line_so_far.size();
+        const char *row_end = (const char *)std::memchr(expected.data + row_start, '\n', expected.length - row_start);
+        std::string expected_row(expected.data + row_start,
+                                 row_end != nullptr ? row_end : expected.data + expected.length);
+        if(!diverged) {
+            actual_row = line_so_far;   //the produced trace stopped early
+        }
+        report = "first difference at line " + std::to_string(line) +
+                 "\n  expected: " + (row_start < expected.length ? expected_row : "<end of trace>") +
+                 "\n  got:      " + (actual_row.empty() && !row_complete ? "<end of trace>" : actual_row);
+        return false;
     }
-    return false;
-}
+};
 
-//Convert a list of strings into a PCB
-PCB add_process(std::vector<std::string> tokens) {
-    PCB process;
-    process.PID = std::stoi(tokens[0]);
-    process.size = std::stoi(tokens[1]);
-    process.arrival_time = std::stoi(tokens[2]);
-    process.processing_time = std::stoi(tokens[3]);
-    process.remaining_time = std::stoi(tokens[3]);
-    process.io_freq = std::stoi(tokens[4]);
-    process.io_duration = std::stoi(tokens[5]);
-    process.start_time = -1;
-    process.partition_number = -1;
-    process.state = NOT_ASSIGNED;
+//Single producer, single consumer ring buffer (power-of-two capacity, larger than
+//SPSC_PUBLISH_BATCH). Each side owns one index (the producer tail, the consumer head) and only
+//reads the other one, so there are no locks; each side also keeps a copy of the other's index and
+//reloads it only when the ring looks full or empty. The producer publishes its tail once every
+//SPSC_PUBLISH_BATCH items (and on close), not after each one, so the cache line holding it does
+//not bounce between the two cores on every push.
+const std::size_t SPSC_PUBLISH_BATCH = 64;
 
-    return process;
-}
+template<typename T>
+struct spsc_channel {
+    std::vector<T>                          ring;
+    std::size_t                             mask;
+    alignas(64) std::atomic<std::size_t>    head{0};        //next item to read, written by the consumer
+    std::size_t                             tail_cache = 0; //consumer's copy of tail
+    alignas(64) std::atomic<std::size_t>    tail{0};        //items published, written by the producer
+    std::size_t                             next = 0;       //producer: next free position
+    std::size_t                             head_cache = 0; //producer's copy of head
+    std::atomic<bool>                       closed{false};
 
-//Returns true if all processes in the queue have terminated
-bool all_process_terminated(std::vector<PCB> processes) {
+    explicit spsc_channel(std::size_t capacity) : ring(capacity), mask(capacity - 1) {}
 
-    for(auto process : processes) {
-        if(process.state != TERMINATED) {
-            return false;
+    //Producer: append item, waiting while the ring is full
+    void push(const T &item) {
+        while(next - head_cache == ring.size()) {
+            head_cache = head.load(std::memory_order_acquire);
+            if(next - head_cache == ring.size()) {
+                std::this_thread::yield();
+            }
+        }
+        ring[next & mask] = item;
+        next++;
+        if(next % SPSC_PUBLISH_BATCH == 0) {
+            tail.store(next, std::memory_order_release);
         }
     }
 
-    return true;
-}
+    //Producer: publish what is left; no more items
+    void close() {
+        tail.store(next, std::memory_order_release);
+        closed.store(true, std::memory_order_release);
+    }
 
-//Terminates a given process
-void terminate_process(PCB &running, std::vector<PCB> &job_queue) {
-    running.remaining_time = 0;
-    running.state = TERMINATED;
-    free_memory(running);
-    sync_queue(job_queue, running);
-}
-
-//set the process in the ready queue to runnning
-void run_process(PCB &running, std::vector<PCB> &job_queue, std::vector<PCB> &ready_queue, unsigned int current_time) {
-    running = ready_queue.back();
-    ready_queue.pop_back();
-    running.start_time = current_time;
-    running.state = RUNNING;
-    sync_queue(job_queue, running);
-}
-
-void idle_CPU(PCB &running) {
-    running.start_time = 0;
-    running.processing_time = 0;
-    running.remaining_time = 0;
-    running.arrival_time = 0;
-    running.io_duration = 0;
-    running.io_freq = 0;
-    running.partition_number = 0;
-    running.size = 0;
-    running.state = NOT_ASSIGNED;
-    running.PID = -1;
+    //Consumer: hand the items available now to f, oldest first, waiting while the ring is empty.
+    //Returns false once the channel is closed and every item was consumed.
+    template<typename F>
+    bool consume(F &&f) {
+        std::size_t position = head.load(std::memory_order_relaxed);
+        while(position == tail_cache) {
+            bool was_closed = closed.load(std::memory_order_acquire);   //before tail: no push is missed
+            tail_cache = tail.load(std::memory_order_acquire);
+            if(position == tail_cache) {
+                if(was_closed) {
+                    return false;
+                }
+                std::this_thread::yield();
+            }
+        }
+        //free the ring in quarters so the producer does not wait for the whole batch
+        std::size_t chunk = std::max<std::size_t>(1, ring.size() / 4);
+        while(position != tail_cache) {
+            std::size_t end = position + std::min(chunk, tail_cache - position);
+            for(; position != end; position++) {
+                f(ring[position & mask]);
+            }
+            head.store(position, std::memory_order_release);
+        }
+        return true;
+    }
+};
+
+enum trace_event_kinds : std::uint8_t {TRACE_HEADER, TRACE_ROW, TRACE_FOOTER};
+
+//What the simulation thread sends to the formatting thread in pipelined mode
+struct trace_event {
+    std::uint32_t       time;
+    std::int32_t        PID;
+    states              old_state;
+    states              new_state;
+    std::uint8_t        cpu;        //TRACE_HEADER: the cpu_column flag
+    trace_event_kinds   kind;
+};
+
+struct trace_writer {
+    char            buffer[TRACE_BUFFER_SIZE];
+    std::size_t     used = 0;
+    int             fd = -1;
+    bool            binary = false;     //write fixed-size records instead of the text table
+    bool            cpu_column = false; //add the CPU of each transition (multi-CPU simulations)
+    bool            failed = false;     //set if a write to fd did not go through
+    trace_comparer  *compare = nullptr; //if set, flushed bytes go to compare->check() instead of fd
+
+    //Pipelined mode: events go over channel to the formatter thread, which writes them with sink
+    std::unique_ptr<spsc_channel<trace_event>>  channel;
+    std::unique_ptr<trace_writer>               sink;
+    std::thread                                 formatter;
+
+    trace_writer() = default;
+    trace_writer(const trace_writer &) = delete;
+    trace_writer& operator=(const trace_writer &) = delete;
+    ~trace_writer() { close(); }
+
+    //Format and write on a second thread from now on. Call after open() (or setting compare) and
+    //before the header; the file and comparer move to the formatting thread's writer.
+    void start_pipeline() {
+        sink = std::make_unique<trace_writer>();
+        sink->fd = fd;
+        sink->binary = binary;
+        sink->compare = compare;
+        fd = -1;
+        compare = nullptr;
+        channel = std::make_unique<spsc_channel<trace_event>>(TRACE_CHANNEL_CAPACITY);
+        formatter = std::thread([this]{
+            auto format = [this](const trace_event &event) {
+                if(event.kind == TRACE_ROW) {
+                    sink->write_status(event.time, event.PID, event.old_state, event.new_state, event.cpu);
+                } else if(event.kind == TRACE_HEADER) {
+                    sink->cpu_column = (event.cpu != 0);
+                    sink->write_header();
+                } else {
+                    sink->write_footer();
+                }
+            };
+            while(channel->consume(format)) {
+            }
+        });
+    }
+
+    //Create (or truncate) filename and write the trace into it
+    bool open(const char *filename) {
+        close();
+        fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        failed = (fd < 0);
+        return !failed;
+    }
+
+    //Flush what is left and close the file; returns false if any write failed
+    bool close() {
+        if(formatter.joinable()) {
+            channel->close();
+            formatter.join();
+            failed |= !sink->close();
+            sink.reset();
+            channel.reset();
+        }
+        if(fd >= 0) {
+            flush();
+            ::close(fd);
+            fd = -1;
+        } else if(compare != nullptr) {
+            flush();
+        }
+        return !failed;
+    }
+
+    void flush() {
+        if(compare != nullptr) {
+            compare->check(buffer, used);
+            used = 0;
+            return;
+        }
+        std::size_t written = 0;
+        while(fd >= 0 && written < used) {
+            ssize_t n = ::write(fd, buffer + written, used - written);
+            if(n <= 0) {
+                failed = true;
+                break;
+            }
+            written += n;
+        }
+        used = 0;
+    }
+
+    //Make sure at least n more bytes fit in the buffer
+    void reserve(std::size_t n) {
+        if(used + n > TRACE_BUFFER_SIZE) {
+            flush();
+        }
+    }
+
+    //Short text only (the table borders); it must fit in the buffer
+    void append(const char *text, std::size_t length) {
+        reserve(length);
+        put(text, length);
+    }
+
+    void append(const std::string &text) {
+        append(text.data(), text.size());
+    }
+
+    //The put/append_field helpers below do not check for room; callers reserve() first
+
+    void put(const char *text, std::size_t length) {
+        std::memcpy(buffer + used, text, length);
+        used += length;
+    }
+
+    //Right align text in a field of width characters (like std::setw, never truncates)
+    void append_field(const char *text, std::size_t length, std::size_t width) {
+        while(length < width) {
+            buffer[used++] = ' ';
+            width--;
+        }
+        put(text, length);
+    }
+
+    void append_field(long long value, std::size_t width) {
+        char digits[24];
+        char *end = digits + sizeof(digits);
+        char *start = end;
+        unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : value;
+        do {
+            *--start = '0' + magnitude % 10;
+            magnitude /= 10;
+        } while(magnitude > 0);
+        if(value < 0) {
+            *--start = '-';
+        }
+        append_field(start, end - start, width);
+    }
+
+    void append_field(states state, std::size_t width) {
+        static const char *const state_names[] = {"NEW", "READY", "RUNNING", "WAITING", "TERMINATED", "NOT_ASSIGNED"};
+        append_field(state_names[state], std::strlen(state_names[state]), width);
+    }
+
+    //Little endian, whatever the host byte order is
+    void put_u32(std::uint32_t value) {
+        for(int i = 0; i < 4; i++) {
+            buffer[used++] = (char)(value >> (8 * i));
+        }
+    }
+
+    void write_header() {
+        if(channel) {
+            channel->push({0, 0, NEW, NEW, (std::uint8_t)cpu_column, TRACE_HEADER});
+            return;
+        }
+        if(binary) {
+            append(cpu_column ? TRACE_MAGIC_CPU : TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        } else {
+            append(print_exec_header(cpu_column));
+        }
+    }
+
+    //Same row as print_exec_status(); cpu is only written with cpu_column
+    void write_status(unsigned int current_time, int PID, states old_state, states new_state, unsigned int cpu = 0) {
+        if(channel) {
+            channel->push({current_time, PID, old_state, new_state, (std::uint8_t)cpu, TRACE_ROW});
+            return;
+        }
+        if(binary) {
+            reserve(TRACE_RECORD_SIZE_CPU);
+            put_u32(current_time);
+            put_u32((std::uint32_t)PID);
+            buffer[used++] = (char)old_state;
+            buffer[used++] = (char)new_state;
+            if(cpu_column) {
+                buffer[used++] = (char)cpu;
+            }
+            return;
+        }
+
+        reserve(128);
+        buffer[used++] = '|';
+        append_field(current_time, 18);
+        put(" |", 2);
+        append_field(PID, 3);
+        put(" |", 2);
+        append_field(old_state, 10);
+        put(" |", 2);
+        append_field(new_state, 10);
+        if(cpu_column) {
+            put(" |", 2);
+            append_field(cpu, 4);
+        }
+        put(" |\n", 3);
+    }
+
+    void write_footer() {
+        if(channel) {
+            channel->push({0, 0, NEW, NEW, 0, TRACE_FOOTER});
+            return;
+        }
+        if(!binary) {
+            append(print_exec_footer(cpu_column));
+        }
+    }
+};
+
+//One transition read back from a binary trace
+struct trace_record {
+    unsigned int    time;
+    int             PID;
+    states          old_state;
+    states          new_state;
+    unsigned int    cpu;            //0 in single CPU traces
+};
+
+//Read-only view of a binary trace. The file is memory mapped, so records are decoded straight
+//from the page cache without copying the file into memory first.
+struct binary_trace_reader {
+    mapped_file     file;
+    bool            has_cpu = false;    //version 2: records carry the CPU
+    std::size_t     record_size = TRACE_RECORD_SIZE;
+
+    //Map filename; on failure error says why
+    bool open(const char *filename, std::string &error) {
+        if(!file.open(filename, error)) {
+            return false;
+        }
+        has_cpu = file.length >= sizeof(TRACE_MAGIC) &&
+                  std::memcmp(file.data, TRACE_MAGIC_CPU, sizeof(TRACE_MAGIC_CPU)) == 0;
+        record_size = has_cpu ? TRACE_RECORD_SIZE_CPU : TRACE_RECORD_SIZE;
+        if(file.length < sizeof(TRACE_MAGIC) ||
+           (!has_cpu && std::memcmp(file.data, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0)) {
+            error = std::string(filename) + " is not a binary trace";
+            file.close();
+            return false;
+        }
+        if((file.length - sizeof(TRACE_MAGIC)) % record_size != 0) {
+            error = std::string(filename) + " ends with a partial record";
+            file.close();
+            return false;
+        }
+        return true;
+    }
+
+    std::size_t size() const {
+        return file.data == nullptr ? 0 : (file.length - sizeof(TRACE_MAGIC)) / record_size;
+    }
+
+    static std::uint32_t get_u32(const unsigned char *bytes) {
+        return (std::uint32_t)bytes[0] | (std::uint32_t)bytes[1] << 8 |
+               (std::uint32_t)bytes[2] << 16 | (std::uint32_t)bytes[3] << 24;
+    }
+
+    trace_record operator[](std::size_t i) const {
+        const unsigned char *record = (const unsigned char *)file.data + sizeof(TRACE_MAGIC) + i * record_size;
+        return {get_u32(record), (int)get_u32(record + 4), (states)record[8], (states)record[9],
+                has_cpu ? (unsigned int)record[10] : 0u};
+    }
+};
+
+//------------------------------------COMMAND LINE----------------------------------------------------
+
+//Parse a comma separated list of positive numbers such as "40,25,15"
+bool parse_number_list(const std::string &text, std::vector<unsigned int> &values) {
+    values.clear();
+    for(auto &token : split_delim(text, ",")) {
+        if(token.empty() || token.find_first_not_of("0123456789") != std::string::npos || token.size() > 9) {
+            return false;
+        }
+        values.push_back(std::stoul(token));
+        if(values.back() == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//Usage text for the options parse_config_arg understands
+const char *const CONFIG_USAGE = "[--partitions 40,25,15,10,8,2] [--allocator fixed|variable] "
+                                 "[--admission fcfs|smallest|best-fit] [--quantum 100] "
+                                 "[--mlfq-quanta 100,200,400] [--mlfq-boost 1000] "
+                                 "[--cpus 1] [--balance push|pull|steal] [--affinity] "
+                                 "[--ready-queue heap|scan]";
+
+//Most levels an MLFQ can have (one bit each in its level bitmap)
+const std::size_t MLFQ_MAX_LEVELS = 32;
+
+//Most CPUs a simulation can have (the binary trace stores the CPU in one byte)
+const unsigned int MAX_CPUS = 256;
+
+//If argv[i] is a simulation setting, read it (and its value, if it takes one) into config and advance i.
+//Returns false if argv[i] is not a setting; error is set if it is one but its value is wrong.
+bool parse_config_arg(int argc, char** argv, int &i, simulation_config &config, std::string &error) {
+    std::string arg = argv[i];
+    if(arg == "--affinity") {
+        config.affinity = true;
+        return true;
+    }
+    if(arg != "--partitions" && arg != "--allocator" && arg != "--admission" && arg != "--quantum" &&
+       arg != "--mlfq-quanta" && arg != "--mlfq-boost" && arg != "--cpus" && arg != "--balance" &&
+       arg != "--ready-queue") {
+        return false;
+    }
+    if(i + 1 >= argc) {
+        error = arg + " needs a value";
+        return true;
+    }
+
+    std::string value = argv[++i];
+    if(arg == "--partitions" && !parse_number_list(value, config.partition_sizes)) {
+        error = "--partitions expects partition sizes such as 40,25,15,10,8,2";
+    } else if(arg == "--allocator") {
+        if(value == "fixed") {
+            config.allocator = FIXED_PARTITIONS;
+        } else if(value == "variable") {
+            config.allocator = VARIABLE_PARTITIONS;
+        } else {
+            error = "--allocator expects fixed or variable";
+        }
+    } else if(arg == "--quantum") {
+        std::vector<unsigned int> values;
+        if(!parse_number_list(value, values) || values.size() != 1) {
+            error = "--quantum expects a positive number of time units";
+        } else {
+            config.quantum = values[0];
+        }
+    } else if(arg == "--mlfq-quanta") {
+        if(!parse_number_list(value, config.mlfq_quanta) || config.mlfq_quanta.size() > MLFQ_MAX_LEVELS) {
+            error = "--mlfq-quanta expects up to 32 time slices, top level first, such as 100,200,400";
+        }
+    } else if(arg == "--mlfq-boost") {
+        if(value == "0") {
+            config.mlfq_boost = 0;
+        } else {
+            std::vector<unsigned int> values;
+            if(!parse_number_list(value, values) || values.size() != 1) {
+                error = "--mlfq-boost expects a number of time units (0: never)";
+            } else {
+                config.mlfq_boost = values[0];
+            }
+        }
+    } else if(arg == "--cpus") {
+        std::vector<unsigned int> values;
+        if(!parse_number_list(value, values) || values.size() != 1 || values[0] > MAX_CPUS) {
+            error = "--cpus expects a number of CPUs from 1 to 256";
+        } else {
+            config.cpus = values[0];
+        }
+    } else if(arg == "--balance") {
+        if(value == "push") {
+            config.balancer = BALANCE_PUSH;
+        } else if(value == "pull") {
+            config.balancer = BALANCE_PULL;
+        } else if(value == "steal") {
+            config.balancer = BALANCE_STEAL;
+        } else {
+            error = "--balance expects push, pull or steal";
+        }
+    } else if(arg == "--ready-queue") {
+        if(value == "heap") {
+            config.ready_queue = READY_HEAP;
+        } else if(value == "scan") {
+            config.ready_queue = READY_SCAN;
+        } else {
+            error = "--ready-queue expects heap or scan";
+        }
+    } else if(arg == "--admission") {
+        if(value == "fcfs") {
+            config.admission = ADMIT_FCFS;
+        } else if(value == "smallest") {
+            config.admission = ADMIT_SMALLEST_FIRST;
+        } else if(value == "best-fit") {
+            config.admission = ADMIT_BEST_FIT;
+        } else {
+            error = "--admission expects fcfs, smallest or best-fit";
+        }
+    }
+    return true;
+}
+
+//Settings shared by the simulator executables
+struct simulator_options {
+    const char         *input_file = nullptr;
+    bool                binary_trace = false;   //--binary: write execution.bin instead of execution.txt
+    bool                metrics = false;        //--metrics: also write metrics.json
+    bool                memory_status = false;  //--memory-status: also write memory_status.txt
+    bool                pipeline = false;       //--pipeline: format the trace on a second thread
+    simulation_config   config;
+
+    const char* output_file() const {
+        return binary_trace ? "execution.bin" : "execution.txt";
+    }
+};
+
+//Parses "<input_file> [--binary] [--metrics] [--memory-status] [--pipeline] [settings]"; prints the usage and returns false if the arguments are wrong
+bool parse_simulator_args(int argc, char** argv, simulator_options &options) {
+    int positional = 0;
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        std::string error;
+        if(parse_config_arg(argc, argv, i, options.config, error)) {
+            if(!error.empty()) {
+                std::cout << "ERROR!\n" << error << std::endl;
+                options.input_file = nullptr;
+                break;
+            }
+        } else if(arg == "--binary") {
+            options.binary_trace = true;
+        } else if(arg == "--metrics") {
+            options.metrics = true;
+        } else if(arg == "--memory-status") {
+            options.memory_status = true;
+        } else if(arg == "--pipeline") {
+            options.pipeline = true;
+        } else if(arg.rfind("--", 0) != 0 && positional == 0) {
+            options.input_file = argv[i];
+            positional++;
+        } else {
+            std::cout << "ERROR!\nUnexpected argument " << arg << std::endl;
+            options.input_file = nullptr;
+            break;
+        }
+    }
+
+    if(options.input_file == nullptr) {
+        std::cout << "To run the program, do: " << argv[0] << " <your_input_file.txt> [--binary] [--metrics] [--memory-status] [--pipeline] "
+                  << CONFIG_USAGE << std::endl;
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------MEMORY ALLOCATOR------------------------------------------------
+//Fixed partitions: free partitions are indexed by size, so the best fit (the smallest free
+//partition that is big enough) is found in O(log P). Among equal sizes the highest numbered
+//partition wins, which is what the original back-to-front scan of the 6 partitions picked.
+//
+//Variable partitions: memory is one range of the total configured size. Free holes are indexed
+//both by size (best fit) and by address (to merge a freed block with its neighbours).
+//
+//In both modes the owner of each allocation is kept in a PID map, so a free is O(1) to find.
+//
+//The usage figures (used, free, usable free, internal fragmentation) are running totals updated
+//by every allocate/release, so reading them never walks the partitions or holes.
+
+struct memory_allocation {
+    std::size_t     partition;      //index in partitions (fixed mode)
+    unsigned int    start;          //first unit of the block (variable mode)
+    unsigned int    length;         //size of the partition or block
+    unsigned int    requested;      //size of the process
+};
+
+//Memory usage at one point in time
+struct memory_usage {
+    unsigned int    used = 0;                   //memory handed out, whole partitions in fixed mode
+    unsigned int    free = 0;                   //total - used
+    unsigned int    usable_free = 0;            //free memory in partitions/holes the smallest process fits in
+    unsigned int    largest_free = 0;           //biggest free partition or hole
+    unsigned int    internal_fragmentation = 0; //sum of (partition size - process size)
+};
+
+struct memory_allocator {
+    allocator_modes                                     mode;
+    std::pmr::vector<memory_partition>                      partitions;     //fixed mode: the table
+    std::pmr::set<std::pair<unsigned int, long>>            free_partitions;//fixed mode: (size, -index)
+    std::pmr::map<unsigned int, unsigned int>               holes;          //variable mode: start -> length
+    std::pmr::set<std::pair<unsigned int, unsigned int>>    holes_by_size;  //variable mode: (length, start)
+    std::pmr::unordered_map<int, memory_allocation>         allocations;    //PID -> what it holds
+    int                                                 next_block = 1; //variable mode block numbers
+
+    unsigned int                                        total = 0;      //sum of the partition sizes
+    unsigned int                                        largest_request = 0;    //biggest size that can ever fit
+    unsigned int                                        used = 0;
+    unsigned int                                        usable_free = 0;
+    unsigned int                                        internal_fragmentation = 0;
+    unsigned int                                        smallest_request = 0;   //see set_smallest_request
+
+    explicit memory_allocator(const simulation_config &config,
+                              std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : mode(config.allocator), partitions(resource), free_partitions(resource), holes(resource),
+          holes_by_size(resource), allocations(resource) {
+        unsigned long long sum = 0;
+        unsigned int largest_partition = 0;
+        for(std::size_t i = 0; i < config.partition_sizes.size(); i++) {
+            partitions.push_back({(unsigned int)i + 1, config.partition_sizes[i], -1});
+            sum += config.partition_sizes[i];
+            largest_partition = std::max(largest_partition, config.partition_sizes[i]);
+        }
+        total = (unsigned int)std::min<unsigned long long>(sum, UINT_MAX);
+        largest_request = mode == FIXED_PARTITIONS ? largest_partition : total;
+
+        if(mode == FIXED_PARTITIONS) {
+            for(std::size_t i = 0; i < partitions.size(); i++) {
+                add_free_partition(partitions[i].size, i);
+            }
+        } else {
+            add_hole(0, total_size());
+        }
+    }
+
+    //Give the process in slot the best fitting memory; false if nothing is big enough
+    bool allocate(process_store &jobs, std::size_t slot) {
+        int PID = jobs.PID[slot];
+        unsigned int size = jobs.size[slot];
+        if(mode == FIXED_PARTITIONS) {
+            auto best = free_partitions.lower_bound({size, LONG_MIN});
+            if(best == free_partitions.end()) {
+                return false;
+            }
+            std::size_t i = -best->second;
+            remove_free_partition(best);
+
+            partitions[i].occupied = PID;
+            jobs.partition_number[slot] = partitions[i].partition_number;
+            allocations[PID] = {i, 0, partitions[i].size, size};
+            used += partitions[i].size;
+            internal_fragmentation += partitions[i].size - size;
+            return true;
+        }
+
+        unsigned int start = 0;
+        if(size > 0) {
+            auto best = holes_by_size.lower_bound({size, 0});
+            if(best == holes_by_size.end()) {
+                return false;
+            }
+            unsigned int length = best->first;
+            start = best->second;
+            remove_hole(start, length);
+            if(length > size) {
+                add_hole(start + size, length - size);
+            }
+        }
+        jobs.partition_number[slot] = next_block++;
+        allocations[PID] = {0, start, size, size};
+        used += size;
+        return true;
+    }
+
+    //Give back what the process in slot holds; false if it holds nothing
+    bool release(process_store &jobs, std::size_t slot) {
+        auto owned = allocations.find(jobs.PID[slot]);
+        if(owned == allocations.end()) {
+            return false;
+        }
+        memory_allocation allocation = owned->second;
+        allocations.erase(owned);
+        jobs.partition_number[slot] = -1;
+        used -= allocation.length;
+
+        if(mode == FIXED_PARTITIONS) {
+            partitions[allocation.partition].occupied = -1;
+            internal_fragmentation -= allocation.length - allocation.requested;
+            add_free_partition(allocation.length, allocation.partition);
+            return true;
+        }
+
+        if(allocation.length == 0) {
+            return true;
+        }
+
+        //merge with the hole right after and the hole right before the block
+        unsigned int start = allocation.start;
+        unsigned int length = allocation.length;
+        auto next = holes.lower_bound(start);
+        if(next != holes.end() && next->first == start + length) {
+            length += next->second;
+            remove_hole(next->first, next->second);
+        }
+        auto previous = holes.lower_bound(start);
+        if(previous != holes.begin()) {
+            --previous;
+            if(previous->first + previous->second == start) {
+                start = previous->first;
+                length += previous->second;
+                remove_hole(previous->first, previous->second);
+            }
+        }
+        add_hole(start, length);
+        return true;
+    }
+
+    //True if size fits once every process has left, i.e. waiting for memory is worth it
+    bool could_ever_fit(unsigned int size) const {
+        return size <= largest_request;
+    }
+
+    //Size of the partition or hole allocate() would pick for size, or UINT_MAX if none is free
+    unsigned int best_fit_length(unsigned int size) const {
+        if(mode == FIXED_PARTITIONS) {
+            auto best = free_partitions.lower_bound({size, LONG_MIN});
+            return best == free_partitions.end() ? UINT_MAX : best->first;
+        }
+        if(size == 0) {
+            return 0;
+        }
+        auto best = holes_by_size.lower_bound({size, 0});
+        return best == holes_by_size.end() ? UINT_MAX : best->first;
+    }
+
+    unsigned int total_size() const {
+        return total;
+    }
+
+    //Free memory in blocks smaller than size can not be used by any process in this run;
+    //usable_free leaves it out. Called once, before the first allocation.
+    void set_smallest_request(unsigned int size) {
+        smallest_request = size;
+        usable_free = 0;
+        for(auto &free_partition : free_partitions) {
+            if(free_partition.first >= smallest_request) {
+                usable_free += free_partition.first;
+            }
+        }
+        for(auto &hole : holes_by_size) {
+            if(hole.first >= smallest_request) {
+                usable_free += hole.first;
+            }
+        }
+    }
+
+    memory_usage usage() const {
+        memory_usage now;
+        now.used = used;
+        now.free = total - used;
+        now.usable_free = usable_free;
+        now.internal_fragmentation = internal_fragmentation;
+        if(mode == FIXED_PARTITIONS) {
+            now.largest_free = free_partitions.empty() ? 0 : free_partitions.rbegin()->first;
+        } else {
+            now.largest_free = holes_by_size.empty() ? 0 : holes_by_size.rbegin()->first;
+        }
+        return now;
+    }
+
+    void add_hole(unsigned int start, unsigned int length) {
+        holes[start] = length;
+        holes_by_size.insert({length, start});
+        if(length >= smallest_request) {
+            usable_free += length;
+        }
+    }
+
+    void remove_hole(unsigned int start, unsigned int length) {
+        holes.erase(start);
+        holes_by_size.erase({length, start});
+        if(length >= smallest_request) {
+            usable_free -= length;
+        }
+    }
+
+    void add_free_partition(unsigned int size, std::size_t index) {
+        free_partitions.insert({size, -(long)index});
+        if(size >= smallest_request) {
+            usable_free += size;
+        }
+    }
+
+    void remove_free_partition(decltype(free_partitions)::iterator free_partition) {
+        if(free_partition->first >= smallest_request) {
+            usable_free -= free_partition->first;
+        }
+        free_partitions.erase(free_partition);
+    }
+};
+
+//------------------------------------MEMORY TIMELINE-------------------------------------------------
+//Follows the allocator's usage figures over a run. Each allocation or free adds the previous
+//figures times the time they held to running areas, so the time-weighted means come out at the
+//end without keeping the events. With a status stream every event is also written as a row.
+
+//Time-weighted averages over [0, end of the run]
+struct memory_summary {
+    unsigned int    total = 0;
+    std::size_t     events = 0;
+    double          mean_used = 0;
+    double          mean_free = 0;
+    double          mean_usable_free = 0;
+    double          mean_internal_fragmentation = 0;
+    double          utilization = 0;            //mean_used / total
+    unsigned int    peak_used = 0;
+    unsigned int    peak_internal_fragmentation = 0;
+};
+
+struct memory_timeline {
+    std::ostream        *status = nullptr;      //optional per event output
+    unsigned int        total = 0;
+    unsigned int        last_time = 0;
+    memory_usage        last;                   //figures since last_time
+    unsigned long long  used_area = 0;
+    unsigned long long  free_area = 0;
+    unsigned long long  usable_free_area = 0;
+    unsigned long long  internal_fragmentation_area = 0;
+    memory_summary      totals;
+
+    static const int tableWidth = 98;
+
+    void start(const memory_allocator &memory, std::ostream *out) {
+        status = out;
+        total = memory.total_size();
+        last = memory.usage();
+        totals.total = total;
+        if(status) {
+            *status << "+" << std::setfill('-') << std::setw(tableWidth) << "+" << std::endl;
+            *status << "|" << std::setfill(' ') << std::setw(10) << "Time"
+                    << std::setw(2) << "|" << std::setw(6) << "Event"
+                    << std::setw(2) << "|" << std::setw(5) << "PID"
+                    << std::setw(2) << "|" << std::setw(9) << "Partition"
+                    << std::setw(2) << "|" << std::setw(8) << "Used"
+                    << std::setw(2) << "|" << std::setw(8) << "Free"
+                    << std::setw(2) << "|" << std::setw(11) << "Usable Free"
+                    << std::setw(2) << "|" << std::setw(10) << "Largest"
+                    << std::setw(2) << "|" << std::setw(13) << "Internal Frag"
+                    << std::setw(2) << "|" << std::endl;
+            *status << "+" << std::setfill('-') << std::setw(tableWidth) << "+" << std::endl;
+        }
+    }
+
+    //Add the figures that held since the last event up to current_time
+    void advance(unsigned int current_time) {
+        unsigned long long span = current_time - last_time;
+        used_area += span * last.used;
+        free_area += span * last.free;
+        usable_free_area += span * last.usable_free;
+        internal_fragmentation_area += span * last.internal_fragmentation;
+        last_time = current_time;
+    }
+
+    //event is "ALLOC" or "FREE"; now is the usage right after it
+    void record(unsigned int current_time, const char *event, int PID, int partition, const memory_usage &now) {
+        advance(current_time);
+        last = now;
+        totals.events++;
+        totals.peak_used = std::max(totals.peak_used, now.used);
+        totals.peak_internal_fragmentation = std::max(totals.peak_internal_fragmentation, now.internal_fragmentation);
+
+        if(status) {
+            *status << "|" << std::setfill(' ') << std::setw(10) << current_time
+                    << std::setw(2) << "|" << std::setw(6) << event
+                    << std::setw(2) << "|" << std::setw(5) << PID
+                    << std::setw(2) << "|" << std::setw(9) << partition
+                    << std::setw(2) << "|" << std::setw(8) << now.used
+                    << std::setw(2) << "|" << std::setw(8) << now.free
+                    << std::setw(2) << "|" << std::setw(11) << now.usable_free
+                    << std::setw(2) << "|" << std::setw(10) << now.largest_free
+                    << std::setw(2) << "|" << std::setw(13) << now.internal_fragmentation
+                    << std::setw(2) << "|" << '\n';
+        }
+    }
+
+    memory_summary summary(unsigned int end_time) {
+        advance(std::max(end_time, last_time));
+        memory_summary result = totals;
+        if(last_time > 0) {
+            result.mean_used = (double)used_area / last_time;
+            result.mean_free = (double)free_area / last_time;
+            result.mean_usable_free = (double)usable_free_area / last_time;
+            result.mean_internal_fragmentation = (double)internal_fragmentation_area / last_time;
+        } else {
+            result.mean_used = last.used;
+            result.mean_free = last.free;
+            result.mean_usable_free = last.usable_free;
+            result.mean_internal_fragmentation = last.internal_fragmentation;
+        }
+        result.utilization = total == 0 ? 0 : result.mean_used / total;
+        return result;
+    }
+
+    //Close the table and append the summary and the processes that never got memory
+    void finish(const memory_summary &summary, const std::vector<PCB> &never_admitted) {
+        if(!status) {
+            return;
+        }
+        *status << "+" << std::setfill('-') << std::setw(tableWidth) << "+" << std::endl;
+        *status << std::setfill(' ') << std::fixed << std::setprecision(2)
+                << "Total memory:                " << summary.total << "\n"
+                << "Events:                      " << summary.events << "\n"
+                << "Mean used:                   " << summary.mean_used << "\n"
+                << "Mean free:                   " << summary.mean_free << "\n"
+                << "Mean usable free:            " << summary.mean_usable_free << "\n"
+                << "Mean internal fragmentation: " << summary.mean_internal_fragmentation << "\n"
+                << "Utilization:                 " << summary.utilization * 100 << "%\n"
+                << "Peak used:                   " << summary.peak_used << "\n"
+                << "Peak internal fragmentation: " << summary.peak_internal_fragmentation << std::endl;
+        if(!never_admitted.empty()) {
+            *status << "Never admitted:\n" << print_PCB(never_admitted);
+        }
+    }
+};
+
+//------------------------------------ADMISSION QUEUE-------------------------------------------------
+//Processes that arrive when no memory fits them stay NEW in the admission queue. The queue is
+//only looked at again when memory is freed (and when a process arrives), never on every tick.
+
+//Smallest process first, earlier arrival on ties
+struct smaller_process_first {
+    const std::pmr::vector<unsigned int> *size;
+
+    bool operator()(std::size_t a, std::size_t b) const {
+        unsigned int size_a = (*size)[a];
+        unsigned int size_b = (*size)[b];
+        return size_a != size_b ? size_a < size_b : a < b;
+    }
+};
+
+struct admission_queue {
+    admission_orders                                order;
+    fifo_queue<std::size_t>                         in_arrival_order;   //ADMIT_FCFS
+    heap_queue<std::size_t, smaller_process_first>  by_size;            //ADMIT_SMALLEST_FIRST
+    std::pmr::vector<std::size_t>                   scan_list;          //ADMIT_BEST_FIT, in arrival order
+
+    admission_queue(admission_orders order, const process_store &jobs)
+        : order(order), in_arrival_order(jobs.resource), by_size({&jobs.size}, jobs.resource),
+          scan_list(jobs.resource) {}
+
+    bool empty() const {
+        return in_arrival_order.empty() && by_size.empty() && scan_list.empty();
+    }
+
+    std::size_t size() const {
+        return in_arrival_order.size() + by_size.size() + scan_list.size();
+    }
+
+    //An arriving process may take free memory right away unless FCFS has processes waiting before it
+    bool may_bypass() const {
+        return order != ADMIT_FCFS || in_arrival_order.empty();
+    }
+
+    void push(std::size_t slot) {
+        if(order == ADMIT_FCFS) {
+            in_arrival_order.push(slot);
+        } else if(order == ADMIT_SMALLEST_FIRST) {
+            by_size.push(slot);
+        } else {
+            scan_list.push_back(slot);
+        }
+    }
+
+    //Allocate memory to waiting processes, in this queue's order, until the next one does not fit.
+    //admitted(slot) is called for every process that got memory.
+    template<typename Admitted>
+    void admit(process_store &jobs, memory_allocator &memory, Admitted &&admitted) {
+        if(order == ADMIT_FCFS) {
+            while(!in_arrival_order.empty() && memory.allocate(jobs, in_arrival_order.top())) {
+                admitted(in_arrival_order.pop());
+            }
+        } else if(order == ADMIT_SMALLEST_FIRST) {
+            while(!by_size.empty() && memory.allocate(jobs, by_size.top())) {
+                admitted(by_size.pop());
+            }
+        } else {
+            while(true) {
+                std::size_t best = scan_list.size();
+                unsigned int least_waste = UINT_MAX;
+                for(std::size_t i = 0; i < scan_list.size(); i++) {
+                    unsigned int size = jobs.size[scan_list[i]];
+                    unsigned int length = memory.best_fit_length(size);
+                    if(length != UINT_MAX && length - size < least_waste) {
+                        least_waste = length - size;
+                        best = i;
+                    }
+                }
+                if(best == scan_list.size()) {
+                    break;
+                }
+                std::size_t slot = scan_list[best];
+                scan_list.erase(scan_list.begin() + best);
+                memory.allocate(jobs, slot);
+                admitted(slot);
+            }
+        }
+    }
+};
+
+//State of one simulation run that the "OS" functions work on. Every run owns its context,
+//so simulations can run side by side in one process.
+struct simulation_context {
+    memory_allocator    memory;
+    memory_timeline     timeline;
+
+    explicit simulation_context(const simulation_config &config,
+                                std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : memory(config, resource) {}
+};
+
+//--------------------------------------------FUNCTIONS FOR THE "OS"-------------------------------------
+
+//Assign memory partition to the process in slot
+bool assign_memory(process_store &jobs, std::size_t slot, simulation_context &context) {
+    return context.memory.allocate(jobs, slot);
+}
+
+//Free a memory partition
+bool free_memory(process_store &jobs, std::size_t slot, simulation_context &context){
+    return context.memory.release(jobs, slot);
+}
+
+//Convert a list of strings into a PCB
+PCB add_process(std::vector<std::string> tokens) {
+    PCB process;
+    process.PID = std::stoi(tokens[0]);
+    process.size = std::stoi(tokens[1]);
+    process.arrival_time = std::stoi(tokens[2]);
+    process.processing_time = std::stoi(tokens[3]);
+    process.remaining_time = std::stoi(tokens[3]);
+    process.io_freq = std::stoi(tokens[4]);
+    process.io_duration = std::stoi(tokens[5]);
+    process.start_time = -1;
+    process.partition_number = -1;
+    process.state = NOT_ASSIGNED;
+
+    return process;
+}
+
+//Returns true if all processes in the queue have terminated
+bool all_process_terminated(const std::vector<PCB> &processes) {
+
+    for(const auto &process : processes) {
+        if(process.state != TERMINATED) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//Terminates a given process
+void terminate_process(process_store &jobs, std::size_t running, simulation_context &context) {
+    jobs.remaining_time[running] = 0;
+    jobs.state[running] = TERMINATED;
+    free_memory(jobs, running, context);
+}
+
+//set a process taken from the ready queue to running
+void run_process(process_store &jobs, std::size_t slot, unsigned int current_time) {
+    jobs.state[slot] = RUNNING;
+    if(jobs.start_time[slot] == -1) {
+        jobs.start_time[slot] = current_time;
+    }
+}
+
+//--------------------------------------------SCHEDULING POLICIES---------------------------------------
+//A policy owns the ready queue and decides the dispatch order. The engine below is templated on the
+//policy, so these hooks are resolved at compile time:
+//  push(slot) / pop() / empty() / size()   the ready queue
+//  preemptive                      check should_preempt(running) whenever the ready queue changes
+//  time_sliced                     give each dispatch a slice of quantum_for(slot) time units
+//  feedback                        tell the policy about quantum_expired(slot) and io_returned(slot)
+//                                  before the process is pushed back, and advance(time) before
+//                                  each scheduling decision; adopt(other, slot) when a process
+//                                  moves to this policy from another CPU's
+//  skip_ahead                      the engine may replay the run / I/O cycles of a process that runs
+//                                  alone in one step (the policy keeps no state that changes per cycle)
+//With several CPUs every CPU has its own policy object (and so its own ready queue).
+
+//First come first served: FIFO order, a process keeps the CPU until it terminates or blocks
+struct FCFS_policy {
+    static constexpr bool preemptive = false;
+    static constexpr bool time_sliced = false;
+    static constexpr bool feedback = false;
+    static constexpr bool skip_ahead = true;
+
+    fifo_queue<std::size_t> ready_queue;
+
+    FCFS_policy(const process_store &jobs, const simulation_config &) : ready_queue(jobs.resource) {}
+
+    bool empty() const { return ready_queue.empty(); }
+    std::size_t size() const { return ready_queue.size(); }
+    void push(std::size_t slot) { ready_queue.push(slot); }
+    std::size_t pop() { return ready_queue.pop(); }
+    bool should_preempt(std::size_t) const { return false; }
+};
+
+//The two ready queues EP and EP_RR can run on (see --ready-queue); both order slots by PID
+typedef heap_queue<std::size_t, lower_PID_first> PID_heap_queue;
+typedef scan_queue<std::size_t, PID_key> PID_scan_queue;
+
+//External priority (smallest PID first), no preemption
+template<typename Queue>
+struct external_priority_policy {
+    static constexpr bool preemptive = false;
+    static constexpr bool time_sliced = false;
+    static constexpr bool feedback = false;
+    static constexpr bool skip_ahead = true;
+
+    Queue ready_queue;
+
+    external_priority_policy(const process_store &jobs, const simulation_config &)
+        : ready_queue({&jobs.PID}, jobs.resource) {}
+
+    bool empty() const { return ready_queue.empty(); }
+    std::size_t size() const { return ready_queue.size(); }
+    void push(std::size_t slot) { ready_queue.push(slot); }
+    std::size_t pop() { return ready_queue.pop(); }
+    bool should_preempt(std::size_t) const { return false; }
+};
+
+//Round robin: FIFO order with a fixed time slice
+struct RR_policy {
+    static constexpr bool preemptive = false;
+    static constexpr bool time_sliced = true;
+    static constexpr bool feedback = false;
+    static constexpr bool skip_ahead = true;
+
+    fifo_queue<std::size_t> ready_queue;
+    unsigned int            quantum;
+
+    RR_policy(const process_store &jobs, const simulation_config &config)
+        : ready_queue(jobs.resource), quantum(config.quantum) {}
+
+    bool empty() const { return ready_queue.empty(); }
+    std::size_t size() const { return ready_queue.size(); }
+    void push(std::size_t slot) { ready_queue.push(slot); }
+    std::size_t pop() { return ready_queue.pop(); }
+    bool should_preempt(std::size_t) const { return false; }
+    unsigned int quantum_for(std::size_t) const { return quantum; }
+};
+
+typedef external_priority_policy<PID_heap_queue> EP_policy;
+typedef external_priority_policy<PID_scan_queue> EP_scan_policy;
+
+//External priority with preemption, round robin time slice between dispatches
+template<typename Queue>
+struct external_priority_RR_policy {
+    static constexpr bool preemptive = true;
+    static constexpr bool time_sliced = true;
+    static constexpr bool feedback = false;
+    static constexpr bool skip_ahead = true;
+
+    Queue           ready_queue;
+    unsigned int    quantum;
+
+    external_priority_RR_policy(const process_store &jobs, const simulation_config &config)
+        : ready_queue({&jobs.PID}, jobs.resource), quantum(config.quantum) {}
+
+    bool empty() const { return ready_queue.empty(); }
+    std::size_t size() const { return ready_queue.size(); }
+    void push(std::size_t slot) { ready_queue.push(slot); }
+    std::size_t pop() { return ready_queue.pop(); }
+    unsigned int quantum_for(std::size_t) const { return quantum; }
+
+    //A ready process with a smaller PID takes the CPU away from the running one
+    bool should_preempt(std::size_t running) const {
+        return !ready_queue.empty() && ready_queue.less(ready_queue.top(), running);
+    }
+};
+
+typedef external_priority_RR_policy<PID_heap_queue> EP_RR_policy;
+typedef external_priority_RR_policy<PID_scan_queue> EP_RR_scan_policy;
+
+//Multilevel feedback queue: one FIFO per level, level 0 first, each with its own time slice.
+//  - a process starts at level 0
+//  - using up its slice moves it one level down
+//  - coming back from I/O moves it one level up
+//  - every boost_interval time units every process goes back to level 0
+//  - a process on a higher level preempts the running one
+//Bit l of non_empty is set while level l has processes, so the highest ready level is one ctz.
+//The boost is lazy: queued processes are moved when it happens, the others (running or waiting)
+//only carry the boost number of their level and are put back on level 0 when they are next pushed.
+struct MLFQ_policy {
+    static constexpr bool preemptive = true;
+    static constexpr bool time_sliced = true;
+    static constexpr bool feedback = true;
+    static constexpr bool skip_ahead = false;
+
+    std::vector<fifo_queue<std::size_t>>    levels;
+    std::vector<unsigned int>               quanta;         //slice of each level
+    std::uint32_t                           non_empty = 0;
+    std::pmr::vector<std::uint8_t>          level;          //by slot: level the process is on
+    std::pmr::vector<unsigned int>          level_epoch;    //by slot: boost count when level was set
+    unsigned int                            epoch = 0;      //boosts so far
+    unsigned int                            boost_interval;
+    unsigned long long                      next_boost;
+
+    MLFQ_policy(const process_store &jobs, const simulation_config &config)
+        : quanta(config.mlfq_quanta), level(jobs.count(), 0, jobs.resource), level_epoch(jobs.count(), 0, jobs.resource),
+          boost_interval(config.mlfq_boost), next_boost(config.mlfq_boost) {
+        if(quanta.empty()) {
+            quanta = {config.quantum, 2 * config.quantum, 4 * config.quantum};
+        }
+        quanta.resize(std::min(quanta.size(), MLFQ_MAX_LEVELS));
+        for(std::size_t l = 0; l < quanta.size(); l++) {
+            levels.emplace_back(jobs.resource);
+        }
+    }
+
+    bool empty() const { return non_empty == 0; }
+
+    std::size_t size() const {
+        std::size_t total = 0;
+        for(auto &queue : levels) {
+            total += queue.size();
+        }
+        return total;
+    }
+
+    void push(std::size_t slot) {
+        if(level_epoch[slot] != epoch) {
+            level[slot] = 0;
+            level_epoch[slot] = epoch;
+        }
+        levels[level[slot]].push(slot);
+        non_empty |= 1u << level[slot];
+    }
+
+    std::size_t pop() {
+        unsigned int top = __builtin_ctz(non_empty);
+        std::size_t slot = levels[top].pop();
+        if(levels[top].empty()) {
+            non_empty &= ~(1u << top);
+        }
+        return slot;
+    }
+
+    //A process on a higher level than the running one is ready
+    bool should_preempt(std::size_t running) const {
+        return non_empty != 0 && (unsigned int)__builtin_ctz(non_empty) < current_level(running);
+    }
+
+    unsigned int quantum_for(std::size_t slot) const { return quanta[current_level(slot)]; }
+
+    void quantum_expired(std::size_t slot) {
+        set_level(slot, std::min<unsigned int>(current_level(slot) + 1, levels.size() - 1));
+    }
+
+    void io_returned(std::size_t slot) {
+        unsigned int current = current_level(slot);
+        set_level(slot, current == 0 ? 0 : current - 1);
+    }
+
+    //Boost if one or more boost times have passed since the last one
+    void advance(unsigned int current_time) {
+        if(boost_interval == 0 || current_time < next_boost) {
+            return;
+        }
+        next_boost = ((unsigned long long)current_time / boost_interval + 1) * boost_interval;
+        epoch++;
+        //queued processes keep their order: level 0 first, then each lower level behind it
+        for(std::size_t l = 1; l < levels.size(); l++) {
+            while(!levels[l].empty()) {
+                std::size_t slot = levels[l].pop();
+                set_level(slot, 0);
+                levels[0].push(slot);
+            }
+        }
+        non_empty = levels[0].empty() ? 0 : 1;
+    }
+
+    unsigned int current_level(std::size_t slot) const {
+        return level_epoch[slot] == epoch ? level[slot] : 0;
+    }
+
+    //The process comes from another CPU: take over the level it had there
+    void adopt(const MLFQ_policy &other, std::size_t slot) {
+        set_level(slot, other.current_level(slot));
+    }
+
+    void set_level(std::size_t slot, unsigned int new_level) {
+        level[slot] = new_level;
+        level_epoch[slot] = epoch;
+    }
+};
+
+//--------------------------------------------SCHEDULING METRICS----------------------------------------
+//Collected while the simulation runs: every state transition updates the counters of the one
+//process it concerns, in O(1), so nothing needs the trace afterwards. Percentiles are taken once
+//at the end over the per-process values.
+
+//Per-process figures, all in simulation time units
+struct process_metrics {
+    int             PID;
+    unsigned int    arrival_time;
+    bool            admitted = false;       //false if it never got memory
+    unsigned int    admitted_time = 0;      //when it got memory and became READY the first time
+    int             first_run_time = -1;    //-1 until it is dispatched once
+    int             finish_time = -1;       //-1 if it never terminated
+    unsigned int    waiting_time = 0;       //time spent READY
+    unsigned int    cpu_time = 0;           //time spent RUNNING
+    unsigned int    io_time = 0;            //time spent WAITING
+    unsigned int    state_since = 0;        //when it entered its current state
+
+    unsigned int turnaround_time() const { return finish_time - arrival_time; }
+    unsigned int response_time() const { return first_run_time - arrival_time; }
+    unsigned int admission_wait() const { return admitted_time - arrival_time; }
+};
+
+//mean / p50 / p95 / p99 / max of one figure over the completed processes
+struct latency_summary {
+    double          mean = 0;
+    unsigned int    p50 = 0;
+    unsigned int    p95 = 0;
+    unsigned int    p99 = 0;
+    unsigned int    max = 0;
+};
+
+//Nearest-rank percentiles; values is reordered
+latency_summary summarize(std::vector<unsigned int> &values) {
+    latency_summary summary;
+    if(values.empty()) {
+        return summary;
+    }
+    auto rank = [&](double percentile) {
+        std::size_t k = (std::size_t)std::ceil(percentile * values.size()) - 1;
+        std::nth_element(values.begin(), values.begin() + k, values.end());
+        return values[k];
+    };
+    double total = 0;
+    for(auto value : values) {
+        total += value;
+    }
+    summary.mean = total / values.size();
+    summary.p50 = rank(0.50);
+    summary.p95 = rank(0.95);
+    summary.p99 = rank(0.99);
+    summary.max = *std::max_element(values.begin(), values.end());
+    return summary;
+}
+
+struct simulation_metrics {
+    std::vector<process_metrics>    processes;      //indexed by slot
+    unsigned int                    makespan = 0;   //time of the last transition
+    std::size_t                     completed = 0;
+    std::size_t                     transitions = 0;    //rows in the trace
+    unsigned long long              cpu_busy = 0;   //summed over the CPUs
+    std::vector<unsigned long long> core_busy;      //by CPU
+    std::vector<std::pair<int, unsigned int>> never_fit;   //(PID, size) of processes too big for memory
+    memory_summary                  memory;         //filled in at the end of the run
+    allocation_stats                allocations;    //the run's arena, filled in at the end
+
+    explicit simulation_metrics(const process_store &jobs, unsigned int cpus = 1) : core_busy(cpus, 0) {
+        processes.reserve(jobs.count());
+        for(std::size_t slot = 0; slot < jobs.count(); slot++) {
+            process_metrics m;
+            m.PID = jobs.PID[slot];
+            m.arrival_time = jobs.arrival_time[slot];
+            processes.push_back(m);
+        }
+    }
+
+    //Account for the process in slot moving from old_state to new_state at current_time on CPU cpu
+    void record(std::size_t slot, unsigned int current_time, states old_state, states new_state, unsigned int cpu = 0) {
+        process_metrics &m = processes[slot];
+        unsigned int spent = current_time - m.state_since;
+        transitions++;
+
+        if(old_state == NEW) {
+            m.admitted = true;
+            m.admitted_time = current_time;
+        } else if(old_state == READY) {
+            m.waiting_time += spent;
+        } else if(old_state == RUNNING) {
+            m.cpu_time += spent;
+            cpu_busy += spent;
+            core_busy[cpu] += spent;
+        } else if(old_state == WAITING) {
+            m.io_time += spent;
+        }
+
+        if(new_state == RUNNING && m.first_run_time == -1) {
+            m.first_run_time = current_time;
+        } else if(new_state == TERMINATED) {
+            m.finish_time = current_time;
+            completed++;
+        }
+
+        m.state_since = current_time;
+        makespan = current_time;
+    }
+
+    //count run / I/O cycles of the process in slot, replayed in one step by the engine: each ran run
+    //time units, waited io time units and was dispatched again, the last time at end_time
+    void record_cycles(std::size_t slot, unsigned int count, unsigned int run, unsigned int io,
+                       unsigned int end_time, unsigned int cpu = 0) {
+        process_metrics &m = processes[slot];
+        transitions += 3 * (std::size_t)count;
+        m.cpu_time += count * run;
+        m.io_time += count * io;
+        cpu_busy += (unsigned long long)count * run;
+        core_busy[cpu] += (unsigned long long)count * run;
+        m.state_since = end_time;
+        makespan = end_time;
+    }
+
+    //Completed processes per time unit
+    double throughput() const {
+        return makespan == 0 ? 0 : (double)completed / makespan;
+    }
+
+    //Fraction of the run the CPUs had a process, averaged over the CPUs
+    double cpu_utilization() const {
+        return makespan == 0 ? 0 : (double)cpu_busy / makespan / core_busy.size();
+    }
+
+    //Fraction of the run one CPU had a process
+    double core_utilization(unsigned int cpu) const {
+        return makespan == 0 ? 0 : (double)core_busy[cpu] / makespan;
+    }
+
+    //Summary of turnaround, waiting or response time (pick with figure) over completed processes
+    latency_summary summary(unsigned int (*figure)(const process_metrics &)) const {
+        std::vector<unsigned int> values;
+        values.reserve(completed);
+        for(auto &m : processes) {
+            if(m.finish_time != -1) {
+                values.push_back(figure(m));
+            }
+        }
+        return summarize(values);
+    }
+};
+
+void write_latency_json(std::ostream &out, const char *name, const latency_summary &summary) {
+    out << "  \"" << name << "\": {\"mean\": " << summary.mean << ", \"p50\": " << summary.p50
+        << ", \"p95\": " << summary.p95 << ", \"p99\": " << summary.p99 << ", \"max\": " << summary.max << "},\n";
+}
+
+//Write the metrics as JSON: run-wide figures first, then one object per process in arrival order.
+//allocations = false leaves out the arena figures, which depend on the standard library and the
+//arena sizing rather than on the simulation (the stored metrics of output_files/ are written so).
+void write_metrics(std::ostream &out, const simulation_metrics &metrics, bool allocations = true) {
+    out << std::fixed << std::setprecision(6);
+    out << "{\n";
+    out << "  \"processes\": " << metrics.processes.size() << ",\n";
+    out << "  \"completed\": " << metrics.completed << ",\n";
+    out << "  \"never_fit\": " << metrics.never_fit.size() << ",\n";
+    out << "  \"transitions\": " << metrics.transitions << ",\n";
+    out << "  \"makespan\": " << metrics.makespan << ",\n";
+    out << "  \"throughput\": " << metrics.throughput() << ",\n";
+    out << "  \"cpu_busy\": " << metrics.cpu_busy << ",\n";
+    out << "  \"cpu_utilization\": " << metrics.cpu_utilization() << ",\n";
+    out << "  \"cpus\": " << metrics.core_busy.size() << ",\n";
+    out << "  \"core_utilization\": [";
+    for(unsigned int cpu = 0; cpu < metrics.core_busy.size(); cpu++) {
+        out << (cpu == 0 ? "" : ", ") << metrics.core_utilization(cpu);
+    }
+    out << "],\n";
+    write_latency_json(out, "turnaround", metrics.summary([](const process_metrics &m){ return m.turnaround_time(); }));
+    write_latency_json(out, "waiting", metrics.summary([](const process_metrics &m){ return m.waiting_time; }));
+    write_latency_json(out, "response", metrics.summary([](const process_metrics &m){ return m.response_time(); }));
+    const memory_summary &memory = metrics.memory;
+    out << "  \"memory\": {\"total\": " << memory.total << ", \"events\": " << memory.events
+        << ", \"mean_used\": " << memory.mean_used << ", \"mean_free\": " << memory.mean_free
+        << ", \"mean_usable_free\": " << memory.mean_usable_free
+        << ", \"mean_internal_fragmentation\": " << memory.mean_internal_fragmentation
+        << ", \"utilization\": " << memory.utilization << ", \"peak_used\": " << memory.peak_used
+        << ", \"peak_internal_fragmentation\": " << memory.peak_internal_fragmentation << "},\n";
+    if(allocations) {
+        out << "  \"allocations\": {\"heap_blocks\": " << metrics.allocations.heap_blocks
+            << ", \"heap_bytes\": " << metrics.allocations.heap_bytes
+            << ", \"loop_heap_blocks\": " << metrics.allocations.loop_heap_blocks << "},\n";
+    }
+    out << "  \"per_process\": [";
+    for(std::size_t i = 0; i < metrics.processes.size(); i++) {
+        const process_metrics &m = metrics.processes[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"pid\": " << m.PID << ", \"arrival\": " << m.arrival_time;
+        if(m.finish_time != -1) {
+            out << ", \"finish\": " << m.finish_time << ", \"turnaround\": " << m.turnaround_time()
+                << ", \"response\": " << m.response_time();
+        }
+        if(m.admitted) {
+            out << ", \"admission_wait\": " << m.admission_wait();
+        }
+        out << ", \"waiting\": " << m.waiting_time
+            << ", \"cpu\": " << m.cpu_time << ", \"io\": " << m.io_time << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+bool write_metrics(const simulation_metrics &metrics, const char *filename, bool allocations = true) {
+    std::ofstream out(filename);
+    if(!out.is_open()) {
+        return false;
+    }
+    write_metrics(out, metrics, allocations);
+    return out.good();
+}
+
+//--------------------------------------------PROFILING-------------------------------------------------
+//Built with -DSIM_PROFILE (make profile), run_simulation times each phase of its event loop, counts
+//scheduling events and queue high-water marks, and prints a report to std::cerr at the end of every run.
+//Without SIM_PROFILE the PROFILE_* macros expand to nothing and none of this is compiled.
+//The loop phases follow each other, so they are timed as laps: PROFILE_LAP(phase) at the end of a phase
+//charges it the time since the previous lap. Trace rows are written from inside the phases and get a
+//scoped timer instead. Timers read the time stamp counter on x86 (steady_clock nanoseconds elsewhere);
+//the report converts ticks to milliseconds with the run's wall clock time.
+
+#ifdef SIM_PROFILE
+
+enum profile_phases {
+    PHASE_ARRIVALS,         //arrivals and their admission
+    PHASE_IO,               //I/O completions
+    PHASE_PREEMPTION,       //feedback advance and the preemption check
+    PHASE_BALANCE,          //pull / steal
+    PHASE_DISPATCH,
+    PHASE_SKIP_AHEAD,       //the lone process fast path
+    PHASE_NEXT_EVENT,       //next event time and running the CPUs up to it
+    PHASE_BOUNDARY,         //finish / I/O / quantum expiry, with the admissions they cause
+    PHASE_TRACE,            //formatting trace rows; nested in the phases above
+    PHASE_COUNT
+};
+
+enum profile_counters {
+    COUNT_ITERATIONS,
+    COUNT_DISPATCHES,       //context switches
+    COUNT_PREEMPTIONS,
+    COUNT_QUANTUM_EXPIRIES,
+    COUNT_IO_BLOCKS,
+    COUNT_MIGRATIONS,       //processes pulled or stolen by another CPU
+    COUNT_SKIPPED_CYCLES,   //run / I/O cycles replayed by the fast path
+    COUNT_COUNT
+};
+
+enum profile_marks {
+    MARK_READY,             //ready processes, over all CPUs
+    MARK_WAITING,           //processes in I/O
+    MARK_ADMISSION,         //processes waiting for memory
+    MARK_COUNT
+};
+
+std::uint64_t profile_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+struct run_profile {
+    std::uint64_t       ticks[PHASE_COUNT] = {};
+    std::uint64_t       calls[PHASE_COUNT] = {};
+    std::uint64_t       counters[COUNT_COUNT] = {};
+    std::size_t         marks[MARK_COUNT] = {};
+    std::uint64_t       start_ticks = profile_ticks();
+    std::uint64_t       last_lap = start_ticks;
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+    //Charge the time since the previous lap to phase
+    void lap(profile_phases phase) {
+        std::uint64_t now = profile_ticks();
+        ticks[phase] += now - last_lap;
+        calls[phase]++;
+        last_lap = now;
+    }
+
+    void high_water(profile_marks mark, std::size_t value) {
+        marks[mark] = std::max(marks[mark], value);
+    }
+
+    //The whole report as one write, so reports of parallel runs (interrupts_batch) do not interleave
+    void report(std::ostream &out, std::size_t processes) const {
+        static const char *const phase_names[] = {"arrivals", "io completions", "preemption", "balance",
+                                                  "dispatch", "skip ahead", "next event", "boundary", "trace rows"};
+        static const char *const counter_names[] = {"loop iterations", "context switches", "preemptions",
+                                                    "quantum expiries", "I/O blocks", "migrations", "skipped cycles"};
+        static const char *const mark_names[] = {"ready queue", "I/O wait queue", "admission queue"};
+
+        double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+        std::uint64_t total = std::max<std::uint64_t>(1, profile_ticks() - start_ticks);
+
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(2);
+        text << "profile: " << processes << " processes, " << wall_ms << " ms\n";
+        for(int phase = 0; phase < PHASE_COUNT; phase++) {
+            text << "  " << std::left << std::setw(18) << phase_names[phase] << std::right
+                 << std::setw(12) << wall_ms * ticks[phase] / total << " ms"
+                 << std::setw(8) << 100.0 * ticks[phase] / total << " %"
+                 << std::setw(14) << calls[phase] << " calls"
+                 << std::setw(10) << (calls[phase] == 0 ? 0.0 : (double)ticks[phase] / calls[phase]) << " ticks/call\n";
+        }
+        for(int counter = 0; counter < COUNT_COUNT; counter++) {
+            text << "  " << std::left << std::setw(18) << counter_names[counter] << std::right
+                 << std::setw(12) << counters[counter] << "\n";
+        }
+        for(int mark = 0; mark < MARK_COUNT; mark++) {
+            text << "  " << std::left << std::setw(18) << (std::string("max ") + mark_names[mark]) << std::right
+                 << std::setw(12) << marks[mark] << "\n";
+        }
+        out << text.str() << std::flush;
+    }
+};
+
+//Adds the time until the end of its scope to one phase
+struct profile_scope {
+    run_profile     &profile;
+    profile_phases  phase;
+    std::uint64_t   start = profile_ticks();
+
+    profile_scope(run_profile &profile, profile_phases phase) : profile(profile), phase(phase) {}
+    ~profile_scope() {
+        profile.ticks[phase] += profile_ticks() - start;
+        profile.calls[phase]++;
+    }
+};
+
+//Ready processes over all CPUs
+template<typename Policy>
+std::size_t ready_processes(const std::pmr::vector<Policy> &policies) {
+    std::size_t total = 0;
+    for(auto &policy : policies) {
+        total += policy.size();
+    }
+    return total;
+}
+
+//These expect a run_profile named profile in scope
+#define PROFILE_LAP(phase) profile.lap(phase)
+#define PROFILE_SCOPE(phase) profile_scope profile_scope_##phase(profile, phase)
+#define PROFILE_COUNT(counter, n) (profile.counters[counter] += (n))
+#define PROFILE_HIGH_WATER(mark, value) profile.high_water(mark, value)
+
+#else
+
+#define PROFILE_LAP(phase)
+#define PROFILE_SCOPE(phase)
+#define PROFILE_COUNT(counter, n)
+#define PROFILE_HIGH_WATER(mark, value)
+
+#endif
+
+//--------------------------------------------SIMULATION ENGINE-----------------------------------------
+
+//main simulator: one event-driven loop shared by every policy. The execution table is streamed to trace,
+//the scheduling metrics are returned. If memory_status is given, every allocation and free is written to it.
+//With config.cpus > 1 each step handles the CPUs in order (0 first) and the trace gets a CPU column;
+//with one CPU the trace is the single CPU table.
+template<typename Policy>
+simulation_metrics run_simulation(std::vector<PCB> list_processes, trace_writer &trace,
+                                  const simulation_config &config = simulation_config(),
+                                  std::ostream *memory_status = nullptr) {
+
+    //Sort input processes by arrival time
+    std::sort(list_processes.begin(), list_processes.end(),
+              [](const PCB &a, const PCB &b){
+                  return a.arrival_time < b.arrival_time;
+              });
+
+    //Everything below that lives only as long as the run allocates from here (see RUN ARENA);
+    //it is declared first so it is released last, in one go
+    run_arena arena(list_processes.size());
+
+    //The job table: every process, indexed by slot. Slots are handed out in arrival order.
+    process_store jobs(list_processes, arena.resource());
+    std::vector<PCB>().swap(list_processes);    //the PCBs themselves are not used from here on
+
+    simulation_context context(config, arena.resource());  //This run's memory
+
+    admission_queue admission(config.admission, jobs);  //Arrived processes waiting for memory
+    io_event_queue wait_queue(arena.resource());        //Slots of processes waiting on I/O, earliest completion first
+
+    //One policy (so one ready queue) per CPU
+    const unsigned int cpus = std::max(1u, config.cpus);
+    std::pmr::vector<Policy> policies(arena.resource());
+    policies.reserve(cpus);
+    for (unsigned int cpu = 0; cpu < cpus; cpu++) {
+        policies.emplace_back(jobs, config);
+    }
+
+    unsigned int current_time = 0;
+    std::pmr::vector<std::size_t> running(cpus, NO_PROCESS, arena.resource());     //Slot of the process on each CPU
+    std::pmr::vector<unsigned int> quantum_remaining(cpus, 0, arena.resource());   //Only used by time sliced policies
+    std::pmr::vector<unsigned int> cpu_of(jobs.count(), 0, arena.resource());      //By slot: CPU whose ready queue it was last put on
+
+    simulation_metrics metrics(jobs, cpus);
+
+    unsigned int smallest_request = jobs.count() == 0 ? 0 : *std::min_element(jobs.size.begin(), jobs.size.end());
+    context.memory.set_smallest_request(smallest_request);
+    context.timeline.start(context.memory, memory_status);
+
+#ifdef SIM_PROFILE
+    run_profile profile;
+#endif
+
+    //Every state change goes through here: one trace row plus the metrics update. cpu is the CPU the
+    //process runs on, or for NEW/WAITING -> READY the CPU whose ready queue it joins.
+    //Leaving NEW means the process was just given memory.
+    auto transition = [&](std::size_t slot, states old_state, states new_state, unsigned int cpu) {
+        {
+            PROFILE_SCOPE(PHASE_TRACE);
+            trace.write_status(current_time, jobs.PID[slot], old_state, new_state, cpu);
+        }
+        metrics.record(slot, current_time, old_state, new_state, cpu);
+        if(old_state == NEW) {
+            context.timeline.record(current_time, "ALLOC", jobs.PID[slot], jobs.partition_number[slot],
+                                    context.memory.usage());
+        }
+    };
+
+    //Processes on a CPU, running or ready
+    auto load = [&](unsigned int cpu) {
+        return policies[cpu].size() + (running[cpu] != NO_PROCESS ? 1 : 0);
+    };
+
+    //CPU whose ready queue the process in slot joins. New processes go to the least loaded CPU;
+    //after that the push balancer keeps doing so, pull and steal send it back to its own CPU.
+    auto place = [&](std::size_t slot, bool arriving) -> unsigned int {
+        if (cpus == 1) {
+            return 0;
+        }
+        if (config.affinity) {
+            return (unsigned int)jobs.PID[slot] % cpus;
+        }
+        if (!arriving && config.balancer != BALANCE_PUSH) {
+            return cpu_of[slot];
+        }
+        unsigned int best = 0;
+        for (unsigned int cpu = 1; cpu < cpus; cpu++) {
+            if (load(cpu) < load(best)) {
+                best = cpu;
+            }
+        }
+        return best;
+    };
+
+    auto enqueue = [&](std::size_t slot, unsigned int cpu) {
+        if constexpr (Policy::feedback) {
+            if (cpu != cpu_of[slot]) {
+                policies[cpu].adopt(policies[cpu_of[slot]], slot);
+            }
+        }
+        cpu_of[slot] = cpu;
+        policies[cpu].push(slot);
+    };
+
+    //make the output table (the header row)
+    trace.cpu_column = (cpus > 1);
+    trace.write_header();
+
+    const unsigned int INF = (unsigned int)-1;
+
+    size_t next_arrival = 0;
+    const size_t total_processes = jobs.count();
+    size_t terminated_processes = 0;
+
+    arena.start_loop();
+    while (true) {
+        PROFILE_COUNT(COUNT_ITERATIONS, 1);
+
+        //arrival
+        while (next_arrival < total_processes &&
+               jobs.arrival_time[next_arrival] == current_time)
+        {
+            jobs.state[next_arrival] = NEW;
+
+            if (!context.memory.could_ever_fit(jobs.size[next_arrival])) {
+                metrics.never_fit.push_back({jobs.PID[next_arrival], jobs.size[next_arrival]});
+            } else if (admission.may_bypass() && assign_memory(jobs, next_arrival, context)) {
+                unsigned int cpu = place(next_arrival, true);
+                transition(next_arrival, NEW, READY, cpu);
+
+                jobs.state[next_arrival] = READY;
+                enqueue(next_arrival, cpu);
+            } else {
+                admission.push(next_arrival);
+            }
+
+            next_arrival++;
+        }
+        PROFILE_LAP(PHASE_ARRIVALS);
+
+        //handle io completion
+        while (wait_queue.due(current_time)) {
+            std::size_t slot = wait_queue.pop();
+
+            unsigned int cpu = place(slot, false);
+            transition(slot, WAITING, READY, cpu);
+
+            jobs.state[slot] = READY;
+            jobs.io_freq[slot] = jobs.io_period[slot];
+
+            if constexpr (Policy::feedback) {
+                policies[cpu_of[slot]].io_returned(slot);
+            }
+            enqueue(slot, cpu);
+        }
+        PROFILE_LAP(PHASE_IO);
+
+        if constexpr (Policy::feedback) {
+            for (auto &policy : policies) {
+                policy.advance(current_time);
+            }
+        }
+
+        //preemption
+        if constexpr (Policy::preemptive) {
+            for (unsigned int cpu = 0; cpu < cpus; cpu++) {
+                std::size_t slot = running[cpu];
+                if (slot != NO_PROCESS && policies[cpu].should_preempt(slot)) {
+                    PROFILE_COUNT(COUNT_PREEMPTIONS, 1);
+                    transition(slot, RUNNING, READY, cpu);
+
+                    jobs.state[slot] = READY;
+                    running[cpu] = NO_PROCESS;
+                    enqueue(slot, place(slot, false));
+                }
+            }
+        }
+        PROFILE_LAP(PHASE_PREEMPTION);
+
+        //pull / steal: a CPU with nothing to do takes work from the CPU with the most processes,
+        //as long as that one has a process waiting behind its running one
+        if (cpus > 1 && !config.affinity && config.balancer != BALANCE_PUSH) {
+            for (unsigned int cpu = 0; cpu < cpus; cpu++) {
+                if (running[cpu] != NO_PROCESS || !policies[cpu].empty()) {
+                    continue;
+                }
+                unsigned int busiest = cpu;
+                for (unsigned int other = 0; other < cpus; other++) {
+                    if (!policies[other].empty() && load(other) >= 2 && (busiest == cpu || load(other) > load(busiest))) {
+                        busiest = other;
+                    }
+                }
+                if (busiest == cpu) {
+                    continue;
+                }
+                std::size_t count = config.balancer == BALANCE_STEAL ? load(busiest) / 2 : 1;
+                count = std::min(count, policies[busiest].size());
+                for (std::size_t i = 0; i < count; i++) {
+                    enqueue(policies[busiest].pop(), cpu);
+                }
+                PROFILE_COUNT(COUNT_MIGRATIONS, count);
+            }
+        }
+        PROFILE_LAP(PHASE_BALANCE);
+        PROFILE_HIGH_WATER(MARK_READY, ready_processes(policies));
+        PROFILE_HIGH_WATER(MARK_WAITING, wait_queue.size());
+        PROFILE_HIGH_WATER(MARK_ADMISSION, admission.size());
+
+        //if a CPU is idle, schedule a new process on it
+        for (unsigned int cpu = 0; cpu < cpus; cpu++) {
+            if (running[cpu] == NO_PROCESS && !policies[cpu].empty()) {
+                std::size_t slot = policies[cpu].pop();
+                running[cpu] = slot;
+                PROFILE_COUNT(COUNT_DISPATCHES, 1);
+
+                transition(slot, READY, RUNNING, cpu);
+
+                run_process(jobs, slot, current_time);
+                if constexpr (Policy::time_sliced) {
+                    quantum_remaining[cpu] = policies[cpu].quantum_for(slot);
+                }
+            }
+        }
+        PROFILE_LAP(PHASE_DISPATCH);
+
+        //skip ahead: a process alone on the only CPU, at the start of an I/O cycle, goes through the
+        //same run / I/O / dispatch cycle again and again until something else happens. Replay count
+        //whole cycles at once; each must leave the process unfinished and end before the next arrival.
+        if constexpr (Policy::skip_ahead) {
+            std::size_t slot = running[0];
+            unsigned int run = slot == NO_PROCESS ? 0 : jobs.io_period[slot];
+            bool whole_slices = true;
+            if constexpr (Policy::time_sliced) {
+                whole_slices = (slot != NO_PROCESS && quantum_remaining[0] >= run &&
+                                policies[0].quantum_for(slot) >= run);
+            }
+            if (cpus == 1 && slot != NO_PROCESS && run > 0 && whole_slices && policies[0].empty() &&
+                wait_queue.empty() && jobs.io_duration[slot] > 0 && jobs.io_freq[slot] == run &&
+                jobs.remaining_time[slot] > run) {
+                unsigned int io = jobs.io_duration[slot];
+                unsigned long long cycle = (unsigned long long)run + io;
+                unsigned long long count = (jobs.remaining_time[slot] - 1) / run;
+                if (next_arrival < total_processes) {
+                    count = std::min(count, (jobs.arrival_time[next_arrival] - current_time - 1) / cycle);
+                }
+
+                if (count > 0) {
+                    int PID = jobs.PID[slot];
+                    unsigned int start_time = current_time;
+                    PROFILE_COUNT(COUNT_SKIPPED_CYCLES, count);
+                    PROFILE_COUNT(COUNT_DISPATCHES, count);
+                    PROFILE_COUNT(COUNT_IO_BLOCKS, count);
+                    for (unsigned long long i = 0; i < count; i++) {
+                        PROFILE_SCOPE(PHASE_TRACE);
+                        unsigned int block_time = (unsigned int)(start_time + i * cycle + run);
+                        trace.write_status(block_time, PID, RUNNING, WAITING);
+                        trace.write_status(block_time + io, PID, WAITING, READY);
+                        trace.write_status(block_time + io, PID, READY, RUNNING);
+                    }
+                    current_time = (unsigned int)(start_time + count * cycle);
+                    metrics.record_cycles(slot, (unsigned int)count, run, io, current_time);
+                    jobs.remaining_time[slot] -= (unsigned int)count * run;
+                    if constexpr (Policy::time_sliced) {
+                        quantum_remaining[0] = policies[0].quantum_for(slot);
+                    }
+                }
+            }
+        }
+        PROFILE_LAP(PHASE_SKIP_AHEAD);
+
+        if (terminated_processes == total_processes) {
+            break;
+        }
+
+        //compute next events
+        unsigned int next_arrival_time = INF;
+        if (next_arrival < total_processes) {
+            next_arrival_time = jobs.arrival_time[next_arrival];
+        }
+
+        unsigned int next_io_time = wait_queue.next_time();
+
+        unsigned int next_cpu_time = INF;
+        for (unsigned int cpu = 0; cpu < cpus; cpu++) {
+            std::size_t slot = running[cpu];
+            if (slot == NO_PROCESS) {
+                continue;
+            }
+            unsigned int cpu_delta = jobs.remaining_time[slot];
+            unsigned int io_freq = jobs.io_freq[slot];
+            if (io_freq > 0 && io_freq < cpu_delta) {
+                cpu_delta = io_freq;
+            }
+            if constexpr (Policy::time_sliced) {
+                if (quantum_remaining[cpu] < cpu_delta) {
+                    cpu_delta = quantum_remaining[cpu];
+                }
+            }
+            next_cpu_time = std::min(next_cpu_time, current_time + cpu_delta);
+        }
+
+        unsigned int next_time = std::min({next_arrival_time, next_io_time, next_cpu_time});
+        if (next_time == INF) {
+            break;
+        }
+
+        //CPU execution; next_time never passes a running process' next boundary
+        unsigned int delta = next_time - current_time;
+        for (unsigned int cpu = 0; cpu < cpus && delta > 0; cpu++) {
+            std::size_t slot = running[cpu];
+            if (slot == NO_PROCESS) {
+                continue;
+            }
+            jobs.remaining_time[slot] -= delta;
+            if constexpr (Policy::time_sliced) {
+                quantum_remaining[cpu] -= delta;
+            }
+
+            if (jobs.io_freq[slot] > 0) {
+                jobs.io_freq[slot] -= delta;
+            }
+        }
+
+        current_time = next_time;
+        PROFILE_LAP(PHASE_NEXT_EVENT);
+
+        //CPU boundary events
+        for (unsigned int cpu = 0; cpu < cpus; cpu++) {
+            std::size_t slot = running[cpu];
+            if (slot == NO_PROCESS) {
+                continue;
+            }
+
+            //case1: process finished
+            if (jobs.remaining_time[slot] == 0) {
+                transition(slot, RUNNING, TERMINATED, cpu);
+
+                int partition = jobs.partition_number[slot];
+                terminate_process(jobs, slot, context);
+                context.timeline.record(current_time, "FREE", jobs.PID[slot], partition, context.memory.usage());
+                terminated_processes++;
+                running[cpu] = NO_PROCESS;
+
+                //the freed memory may let waiting processes in
+                if (!admission.empty()) {
+                    admission.admit(jobs, context.memory, [&](std::size_t admitted){
+                        unsigned int target = place(admitted, true);
+                        transition(admitted, NEW, READY, target);
+
+                        jobs.state[admitted] = READY;
+                        enqueue(admitted, target);
+                    });
+                }
+            }
+            //case2: io triggered
+            else if (jobs.io_freq[slot] == 0 && jobs.io_duration[slot] > 0) {
+                PROFILE_COUNT(COUNT_IO_BLOCKS, 1);
+                transition(slot, RUNNING, WAITING, cpu);
+
+                jobs.state[slot] = WAITING;
+                wait_queue.push(current_time + jobs.io_duration[slot], slot);
+                running[cpu] = NO_PROCESS;
+            }
+            //case3: quantum expired
+            else if (Policy::time_sliced && quantum_remaining[cpu] == 0) {
+                PROFILE_COUNT(COUNT_QUANTUM_EXPIRIES, 1);
+                transition(slot, RUNNING, READY, cpu);
+
+                jobs.state[slot] = READY;
+                running[cpu] = NO_PROCESS;
+                if constexpr (Policy::feedback) {
+                    policies[cpu_of[slot]].quantum_expired(slot);
+                }
+                enqueue(slot, place(slot, false));
+            }
+        }
+        PROFILE_LAP(PHASE_BOUNDARY);
+    }
+
+    //Close the output table
+    trace.write_footer();
+
+#ifdef SIM_PROFILE
+    profile.report(std::cerr, total_processes);
+#endif
+
+    metrics.memory = context.timeline.summary(metrics.makespan);
+    metrics.allocations = arena.stats();
+    if (memory_status) {
+        context.timeline.finish(metrics.memory, jobs.views_in_state(NEW));
+    }
+
+    return metrics;
+}
+
+//Policies that can be picked by name at run time
+const char *const POLICY_NAMES[] = {"FCFS", "EP", "RR", "EP_RR", "MLFQ"};
+
+bool is_policy_name(const std::string &name) {
+    return std::find(std::begin(POLICY_NAMES), std::end(POLICY_NAMES), name) != std::end(POLICY_NAMES);
+}
+
+//Run the policy called name (one of POLICY_NAMES). Throws std::invalid_argument if there is no such policy.
+simulation_metrics run_simulation_by_name(const std::string &name, std::vector<PCB> list_processes,
+                                          trace_writer &trace, const simulation_config &config = simulation_config(),
+                                          std::ostream *memory_status = nullptr) {
+    if(name == "FCFS") {
+        return run_simulation<FCFS_policy>(std::move(list_processes), trace, config, memory_status);
+    } else if(name == "EP" && config.ready_queue == READY_SCAN) {
+        return run_simulation<EP_scan_policy>(std::move(list_processes), trace, config, memory_status);
+    } else if(name == "EP") {
+        return run_simulation<EP_policy>(std::move(list_processes), trace, config, memory_status);
+    } else if(name == "RR") {
+        return run_simulation<RR_policy>(std::move(list_processes), trace, config, memory_status);
+    } else if(name == "EP_RR" && config.ready_queue == READY_SCAN) {
+        return run_simulation<EP_RR_scan_policy>(std::move(list_processes), trace, config, memory_status);
+    } else if(name == "EP_RR") {
+        return run_simulation<EP_RR_policy>(std::move(list_processes), trace, config, memory_status);
+    } else if(name == "MLFQ") {
+        return run_simulation<MLFQ_policy>(std::move(list_processes), trace, config, memory_status);
+    }
+    throw std::invalid_argument("unknown policy " + name);
+}
+
+//--------------------------------------------SIMULATOR MAIN--------------------------------------------
+//The whole main() of the EP, RR, EP_RR and MLFQ simulators: they only differ in the policy they run
+
+int simulator_main(int argc, char** argv, const std::string &policy) {
+
+    //Get the input file (and options) from the user
+    simulator_options options;
+    if(!parse_simulator_args(argc, argv, options)) {
+        return -1;
+    }
+
+    //Parse the entire input file into a vector of PCBs (see parse_input_file)
+    std::vector<PCB> list_process;
+    std::string error;
+    if (!parse_input_file(options.input_file, list_process, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return -1;
+    }
+
+    trace_writer trace;
+    trace.binary = options.binary_trace;
+    if (!trace.open(options.output_file())) {
+        std::cerr << "Error opening file!" << std::endl;
+        return -1;
+    }
+    if (options.pipeline) {
+        trace.start_pipeline();
+    }
+
+    std::ofstream memory_status;
+    if (options.memory_status) {
+        memory_status.open("memory_status.txt");
+        if (!memory_status.is_open()) {
+            std::cerr << "Error opening memory_status.txt" << std::endl;
+            return -1;
+        }
+    }
+
+    //With the list of processes, run the simulation. The trace is streamed to the output file.
+    simulation_metrics metrics = run_simulation_by_name(policy, std::move(list_process), trace, options.config,
+                                                        options.memory_status ? &memory_status : nullptr);
+
+    if (!trace.close()) {
+        std::cerr << "Error writing file!" << std::endl;
+        return -1;
+    }
+    std::cout << "Output generated in " << options.output_file() << std::endl;
+
+    for (auto &process : metrics.never_fit) {
+        std::cerr << "Warning: process " << process.first << " (size " << process.second
+                  << ") does not fit in memory and is never admitted" << std::endl;
+    }
+
+    if (options.memory_status) {
+        memory_status.close();
+        if (memory_status.fail()) {
+            std::cerr << "Error writing memory_status.txt" << std::endl;
+            return -1;
+        }
+        std::cout << "Memory status written to memory_status.txt" << std::endl;
+    }
+
+    if (options.metrics) {
+        if (!write_metrics(metrics, "metrics.json")) {
+            std::cerr << "Error writing metrics.json" << std::endl;
+            return -1;
+        }
+        std::cout << "Metrics written to metrics.json" << std::endl;
+    }
+
+    return 0;
 }
 
 #endif
\ No newline at end of file
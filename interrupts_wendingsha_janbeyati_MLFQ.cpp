@@ -0,0 +1,12 @@
+/**
+ * @file interrupts_wendingsha_janbeyati_MLFQ.cpp
+ * @author wendingsha
+ * @brief main.cpp file for the Multilevel Feedback Queue Scheduler
+ * 
+ */
+
+#include "interrupts_wendingsha_janbeyati.hpp"
+
+int main(int argc, char** argv) {
+    return simulator_main(argc, argv, "MLFQ");
+}
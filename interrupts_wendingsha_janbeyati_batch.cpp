@@ -0,0 +1,273 @@
+/**
+ * @file interrupts_wendingsha_janbeyati_batch.cpp
+ * @author wendingsha
+ * @brief Runs many input files through many policies at once, one simulation per core
+ *
+ */
+
+#include "interrupts_wendingsha_janbeyati.hpp"
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+//One simulation: an input file run under one policy
+struct batch_job {
+    std::string     input_file;
+    std::string     policy;
+    std::string     output_file;    //with --check: the stored trace to compare against
+    std::string     metrics_file;   //empty unless --metrics; with --check: the stored metrics
+    std::string     memory_file;    //empty unless --memory-status
+    std::string     error;      //empty if the job succeeded
+    std::vector<std::pair<int, unsigned int>> never_fit;   //(PID, size) of processes too big for memory
+};
+
+//A worker's share of the jobs. The owner takes from the front, idle workers steal from the back.
+struct job_deque {
+    std::mutex                  lock;
+    std::deque<std::size_t>     jobs;
+};
+
+//Fixed set of jobs spread over the workers up front. A worker that runs out steals from the
+//others, so one slow workload does not leave the other cores idle at the end of the sweep.
+template<typename Work>
+void run_work_stealing(std::size_t job_count, unsigned int threads, Work &&work) {
+    std::vector<job_deque> queues(threads);
+    for(std::size_t i = 0; i < job_count; i++) {
+        queues[i % threads].jobs.push_back(i);
+    }
+
+    auto take = [&](unsigned int worker, std::size_t &job) {
+        {
+            std::lock_guard<std::mutex> guard(queues[worker].lock);
+            if(!queues[worker].jobs.empty()) {
+                job = queues[worker].jobs.front();
+                queues[worker].jobs.pop_front();
+                return true;
+            }
+        }
+        for(unsigned int i = 1; i < threads; i++) {
+            job_deque &victim = queues[(worker + i) % threads];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if(!victim.jobs.empty()) {
+                job = victim.jobs.back();
+                victim.jobs.pop_back();
+                return true;
+            }
+        }
+        return false;   //no job is ever added later, so every queue being empty means we are done
+    };
+
+    std::vector<std::thread> workers;
+    for(unsigned int worker = 0; worker < threads; worker++) {
+        workers.emplace_back([&, worker]{
+            std::size_t job;
+            while(take(worker, job)) {
+                work(job);
+            }
+        });
+    }
+    for(auto &worker : workers) {
+        worker.join();
+    }
+}
+
+//Compare the metrics, as write_metrics writes them for the batch runner (no allocations), with the
+//stored file
+bool check_metrics(const simulation_metrics &metrics, const std::string &filename, std::string &report) {
+    trace_comparer comparer;
+    if(!comparer.open(filename.c_str(), report)) {
+        return false;
+    }
+    std::ostringstream out;
+    write_metrics(out, metrics, false);
+    std::string produced = out.str();
+    comparer.check(produced.data(), produced.size());
+    return comparer.finish(report);
+}
+
+//Parse the input, run the policy and stream the trace into the job's own output file,
+//or with check compare it on the fly with the stored trace in job.output_file
+void run_batch_job(batch_job &job, bool binary_trace, bool check, const simulation_config &config) {
+    std::vector<PCB> list_process;
+    if(!parse_input_file(job.input_file.c_str(), list_process, job.error)) {
+        return;
+    }
+
+    trace_comparer comparer;
+    trace_writer trace;
+    trace.binary = binary_trace;
+    if(check) {
+        if(!comparer.open(job.output_file.c_str(), job.error)) {
+            return;
+        }
+        trace.compare = &comparer;
+    } else if(!trace.open(job.output_file.c_str())) {
+        job.error = "Unable to open output file: " + job.output_file;
+        return;
+    }
+
+    std::ofstream memory_status;
+    if(!job.memory_file.empty()) {
+        memory_status.open(job.memory_file);
+        if(!memory_status.is_open()) {
+            job.error = "Unable to open output file: " + job.memory_file;
+            return;
+        }
+    }
+
+    simulation_metrics metrics = run_simulation_by_name(job.policy, std::move(list_process), trace, config,
+                                                        job.memory_file.empty() ? nullptr : &memory_status);
+
+    if(!job.memory_file.empty()) {
+        memory_status.close();
+    }
+    job.never_fit = metrics.never_fit;
+
+    std::string report;
+    if(!trace.close()) {
+        job.error = "Error writing file: " + job.output_file;
+    } else if(check && !comparer.finish(report)) {
+        job.error = job.output_file + ": " + report;
+    } else if(!job.memory_file.empty() && memory_status.fail()) {
+        job.error = "Error writing file: " + job.memory_file;
+    } else if(!job.metrics_file.empty() && check) {
+        if(!check_metrics(metrics, job.metrics_file, report)) {
+            job.error = job.metrics_file + ": " + report;
+        }
+    } else if(!job.metrics_file.empty() && !write_metrics(metrics, job.metrics_file.c_str(), false)) {
+        job.error = "Error writing file: " + job.metrics_file;
+    }
+}
+
+void print_usage(const char *program) {
+    std::cout << "To run the program, do: " << program
+              << " [--policies EP,RR,EP_RR] [--threads N] [--output-dir DIR | --check DIR] [--binary] [--metrics]"
+              << " [--memory-status] "
+              << CONFIG_USAGE << " <input_files...>" << std::endl;
+    std::cout << "Available policies:";
+    for(auto name : POLICY_NAMES) {
+        std::cout << " " << name;
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char** argv) {
+
+    std::vector<std::string> policies = {"EP", "RR", "EP_RR"};
+    std::vector<std::string> inputs;
+    std::string output_dir = "output_files";
+    std::string check_dir;          //--check: compare against the traces in here instead of writing
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    bool binary_trace = false;
+    bool write_metrics_files = false;
+    bool write_memory_files = false;
+    simulation_config config;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        std::string error;
+        if(parse_config_arg(argc, argv, i, config, error)) {
+            if(!error.empty()) {
+                std::cout << "ERROR!\n" << error << std::endl;
+                print_usage(argv[0]);
+                return -1;
+            }
+        } else if(arg == "--policies" && has_value) {
+            policies = split_delim(argv[++i], ",");
+            for(auto &policy : policies) {
+                if(!is_policy_name(policy)) {
+                    std::cout << "ERROR!\nUnknown policy " << policy << std::endl;
+                    print_usage(argv[0]);
+                    return -1;
+                }
+            }
+        } else if(arg == "--threads" && has_value) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else if(arg == "--output-dir" && has_value) {
+            output_dir = argv[++i];
+        } else if(arg == "--check" && has_value) {
+            check_dir = argv[++i];
+        } else if(arg == "--binary") {
+            binary_trace = true;
+        } else if(arg == "--metrics") {
+            write_metrics_files = true;
+        } else if(arg == "--memory-status") {
+            write_memory_files = true;
+        } else if(arg.rfind("--", 0) == 0) {
+            std::cout << "ERROR!\nUnexpected argument " << arg << std::endl;
+            print_usage(argv[0]);
+            return -1;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if(inputs.empty()) {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    bool check = !check_dir.empty();
+    if(!check || write_memory_files) {
+        mkdir(output_dir.c_str(), 0755);
+    }
+
+    //Same output names build.sh has always used: execution_<POLICY>_<input file name>,
+    //plus metrics_<POLICY>_<input file stem>.json with --metrics and memory_<POLICY>_<input file stem>.txt
+    //with --memory-status. --check compares the traces, and the metrics with --metrics, against the
+    //stored ones.
+    std::vector<batch_job> jobs;
+    for(auto &policy : policies) {
+        for(auto &input : inputs) {
+            std::string base = input.substr(input.find_last_of('/') + 1);
+            std::string stem = base.substr(0, base.find_last_of('.'));
+            if(binary_trace) {
+                base = stem + ".bin";
+            }
+            std::string metrics_file;
+            if(write_metrics_files) {
+                metrics_file = (check ? check_dir : output_dir) + "/metrics_" + policy + "_" + stem + ".json";
+            }
+            std::string memory_file;
+            if(write_memory_files) {
+                memory_file = output_dir + "/memory_" + policy + "_" + stem + ".txt";
+            }
+            std::string trace_dir = check ? check_dir : output_dir;
+            jobs.push_back({input, policy, trace_dir + "/execution_" + policy + "_" + base, metrics_file,
+                            memory_file, "", {}});
+        }
+    }
+
+    threads = std::min<std::size_t>(threads, jobs.size());
+    auto start = std::chrono::steady_clock::now();
+
+    run_work_stealing(jobs.size(), threads, [&](std::size_t i){
+        run_batch_job(jobs[i], binary_trace, check, config);
+    });
+
+    auto stop = std::chrono::steady_clock::now();
+
+    int failed = 0;
+    for(auto &job : jobs) {
+        for(auto &process : job.never_fit) {
+            std::cerr << "Warning: " << job.policy << " on " << job.input_file << ": process " << process.first
+                      << " (size " << process.second << ") does not fit in memory and is never admitted" << std::endl;
+        }
+        if(!job.error.empty()) {
+            std::cerr << "Error: " << job.policy << " on " << job.input_file << ": " << job.error << std::endl;
+            failed++;
+        }
+    }
+
+    if(check) {
+        std::cout << jobs.size() - failed << " of " << jobs.size() << " traces match " << check_dir;
+    } else {
+        std::cout << jobs.size() - failed << " of " << jobs.size() << " simulations written to " << output_dir;
+    }
+    std::cout << "/ using " << threads << " threads in "
+              << std::chrono::duration<double, std::milli>(stop - start).count() << " ms" << std::endl;
+
+    return failed == 0 ? 0 : -1;
+}
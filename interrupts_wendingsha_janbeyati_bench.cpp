@@ -0,0 +1,353 @@
+/**
+ * @file interrupts_wendingsha_janbeyati_bench.cpp
+ * @author wendingsha
+ * @brief Benchmarks for the simulator
+ *
+ */
+
+#include "interrupts_wendingsha_janbeyati.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+//Every heap allocation of this program goes through these, so bench_allocations can count them
+std::atomic<std::size_t> heap_allocations{0};
+
+void* operator new(std::size_t n) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if(void *p = std::malloc(n == 0 ? 1 : n)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t n, std::align_val_t alignment) {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    std::size_t align = (std::size_t)alignment;
+    if(void *p = std::aligned_alloc(align, (n + align - 1) / align * align)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+//malloc and free do pair up here; gcc cannot tell once it has inlined a standard allocator
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+//Wall clock time of one call to f, in milliseconds
+template<typename F>
+double time_ms(F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+//The input path the simulators used before parse_input_file: getline + split_delim + add_process
+void legacy_parse(const char *filename, std::vector<PCB> &processes) {
+    std::ifstream input_file(filename);
+    std::string line;
+    while(std::getline(input_file, line)) {
+        auto input_tokens = split_delim(line, ", ");
+        processes.push_back(add_process(input_tokens));
+    }
+}
+
+bool same_processes(const std::vector<PCB> &a, const std::vector<PCB> &b) {
+    if(a.size() != b.size()) {
+        return false;
+    }
+    for(std::size_t i = 0; i < a.size(); i++) {
+        if(a[i].PID != b[i].PID || a[i].size != b[i].size || a[i].arrival_time != b[i].arrival_time ||
+           a[i].processing_time != b[i].processing_time || a[i].io_freq != b[i].io_freq ||
+           a[i].io_duration != b[i].io_duration) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//Parse the same file with both input paths
+void bench_parse(std::size_t lines) {
+    const char *filename = "bench_input.txt";
+    {
+        std::ofstream out(filename);
+        for(std::size_t i = 0; i < lines; i++) {
+            //every 7th line uses the doubled space seen in input_extra_test14.txt
+            out << i + 1 << ", " << 1 + i % 40 << ", " << i / 4 << ", " << 1 + i % 97
+                << (i % 7 == 0 ? ",  " : ", ") << i % 13 << ", " << i % 5 << "\n";
+        }
+    }
+
+    std::vector<PCB> legacy, fast;
+    std::string error;
+    double legacy_ms = time_ms([&]{ legacy_parse(filename, legacy); });
+    double fast_ms = time_ms([&]{ parse_input_file(filename, fast, error); });
+    std::remove(filename);
+
+    std::cout << "parse " << lines << " lines" << std::endl;
+    std::cout << "  getline + split_delim + stoi: " << std::fixed << std::setprecision(1) << legacy_ms << " ms" << std::endl;
+    std::cout << "  parse_input_file (mmap):      " << fast_ms << " ms  (" << legacy_ms / fast_ms << "x)" << std::endl;
+    if(!error.empty() || !same_processes(legacy, fast)) {
+        std::cout << "  MISMATCH between the two parsers " << error << std::endl;
+    }
+}
+
+//Fastest of repetitions calls to f, in milliseconds
+template<typename F>
+double best_ms(unsigned int repetitions, F &&f) {
+    double best = 0;
+    for(unsigned int i = 0; i < repetitions; i++) {
+        double ms = time_ms(f);
+        if(i == 0 || ms < best) {
+            best = ms;
+        }
+    }
+    return best;
+}
+
+//speedup > 0 is printed after the row as "(N.NNx)"
+void print_row(const std::string &name, double ms, std::size_t events, double speedup = 0) {
+    std::cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(12) << ms << " ms";
+    if(events > 0) {
+        std::cout << std::setw(12) << events << " events" << std::setw(14) << std::setprecision(0)
+                  << events / (ms / 1000) << " events/s";
+    }
+    if(speedup > 0) {
+        std::cout << "  (" << std::setprecision(2) << speedup << "x)";
+    }
+    std::cout << std::endl;
+}
+
+//Every phase of a simulator run on a generated workload of each size:
+//  parse     parse_input_file on the generated file
+//  simulate  the engine alone (binary records into a trace that is never written out)
+//  output    the extra time of writing the text table to a file
+//  pipelined the whole run (engine plus text table) with the table formatted and written on a
+//            second thread (trace_writer::start_pipeline), and its speedup over the serial run
+void bench_simulate(const std::vector<unsigned int> &sizes, unsigned int repetitions, std::uint64_t seed) {
+    const char *input_name = "bench_workload.txt";
+    const char *trace_name = "bench_execution.txt";
+
+    std::cout << std::left << std::setw(32) << "Benchmark" << std::right << std::setw(15) << "Time"
+              << std::setw(19) << "Transitions" << std::setw(24) << "Rate" << std::endl;
+
+    for(auto size : sizes) {
+        workload_spec spec;
+        spec.processes = size;
+        spec.seed = seed;
+        if(!write_workload(generate_workload(spec), input_name)) {
+            std::cout << "Error writing " << input_name << std::endl;
+            return;
+        }
+
+        std::vector<PCB> processes;
+        std::string error;
+        double parse_ms = best_ms(repetitions, [&]{
+            processes.clear();
+            parse_input_file(input_name, processes, error);
+        });
+        if(!error.empty()) {
+            std::cout << "Error: " << error << std::endl;
+            return;
+        }
+        print_row("parse/" + std::to_string(size), parse_ms, 0);
+
+        for(auto policy : POLICY_NAMES) {
+            std::size_t transitions = 0;
+            double simulate_ms = best_ms(repetitions, [&]{
+                trace_writer discard;   //never opened: flush() drops the buffer
+                discard.binary = true;
+                transitions = run_simulation_by_name(policy, processes, discard).transitions;
+            });
+            double total_ms = best_ms(repetitions, [&]{
+                trace_writer trace;
+                trace.open(trace_name);
+                run_simulation_by_name(policy, processes, trace);
+            });
+            double pipelined_ms = best_ms(repetitions, [&]{
+                trace_writer trace;
+                trace.open(trace_name);
+                trace.start_pipeline();
+                run_simulation_by_name(policy, processes, trace);
+                trace.close();
+            });
+            std::string suffix = std::string(policy) + "/" + std::to_string(size);
+            print_row("simulate/" + suffix, simulate_ms, transitions);
+            print_row("output/" + suffix, std::max(0.0, total_ms - simulate_ms), transitions);
+            print_row("pipelined/" + suffix, pipelined_ms, transitions, total_ms / pipelined_ms);
+        }
+    }
+
+    std::remove(input_name);
+    std::remove(trace_name);
+}
+
+//The engine alone on a few long, CPU-bound processes that block for I/O every few time units and
+//rarely overlap: the case the skip-ahead fast path replays in closed form. MLFQ opts out of it, so
+//its row is the cost of going through the loop once per I/O cycle.
+void bench_cpu_bound(unsigned int repetitions, std::uint64_t seed) {
+    workload_spec spec;
+    spec.processes = 30;
+    spec.seed = seed;
+    std::string error;
+    parse_distribution("exp:300000", spec.interarrival, error);
+    parse_distribution("uniform:10000:200000", spec.burst, error);
+    parse_distribution("uniform:1:5", spec.io_freq, error);
+    parse_distribution("uniform:1:3", spec.io_duration, error);
+    std::vector<PCB> processes = generate_workload(spec);
+
+    for(auto policy : POLICY_NAMES) {
+        std::size_t transitions = 0;
+        double simulate_ms = best_ms(repetitions, [&]{
+            trace_writer discard;
+            discard.binary = true;
+            transitions = run_simulation_by_name(policy, processes, discard).transitions;
+        });
+        print_row(std::string("cpu-bound/") + policy, simulate_ms, transitions);
+    }
+}
+
+//Heap allocations of one whole run_simulation() call (copy of the input, sort, arena, metrics...)
+//for workloads of each size, next to the arena blocks taken while the event loop ran. The first
+//number should not grow with the workload and the second should be 0.
+void bench_allocations(const std::vector<unsigned int> &sizes, std::uint64_t seed) {
+    std::cout << std::left << std::setw(32) << "Allocations" << std::right << std::setw(15) << "Heap/run"
+              << std::setw(19) << "Arena blocks" << std::setw(24) << "In the event loop" << std::endl;
+
+    for(auto size : sizes) {
+        workload_spec spec;
+        spec.processes = size;
+        spec.seed = seed;
+        std::vector<PCB> processes = generate_workload(spec);
+
+        for(auto policy : POLICY_NAMES) {
+            trace_writer discard;
+            discard.binary = true;
+            std::size_t before = heap_allocations.load();
+            allocation_stats arena = run_simulation_by_name(policy, processes, discard).allocations;
+            std::size_t during = heap_allocations.load() - before;
+            std::cout << std::left << std::setw(32) << std::string(policy) + "/" + std::to_string(size) << std::right
+                      << std::setw(15) << during << std::setw(19) << arena.heap_blocks
+                      << std::setw(24) << arena.loop_heap_blocks << std::endl;
+        }
+    }
+}
+
+//Keeps the compiler from dropping a benchmark loop whose result is unused
+volatile std::size_t bench_sink;
+
+//argmin kernel at every SIMD level against the loop the simulators used before: an argmin over the
+//PID field of a vector of PCBs
+void bench_kernels(std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    simd_levels supported = detect_simd_level();
+    const char *level_names[] = {"scalar", "sse4.1", "avx2"};
+
+    std::cout << std::left << std::setw(32) << "Kernel" << std::right << std::setw(15) << "Time/call" << std::endl;
+
+    for(std::size_t n : {16, 256, 4096, 65536}) {
+        std::vector<std::int32_t> keys(n);
+        std::vector<PCB> pcbs(n);
+        for(std::size_t i = 0; i < n; i++) {
+            keys[i] = (std::int32_t)(rng() % (n / 2 + 1));  //plenty of ties
+            pcbs[i].PID = keys[i];
+        }
+
+        //Every level must agree with the scalar kernel
+        for(int level = SIMD_SSE41; level <= supported; level++) {
+            for(std::size_t length = 0; length <= std::min<std::size_t>(n, 40); length++) {
+                if(argmin_i32_for((simd_levels)level)(keys.data(), length) != argmin_i32_scalar(keys.data(), length)) {
+                    std::cout << "  MISMATCH at " << level_names[level] << " length " << length << std::endl;
+                }
+            }
+            if(argmin_i32_for((simd_levels)level)(keys.data(), n) != argmin_i32_scalar(keys.data(), n)) {
+                std::cout << "  MISMATCH at " << level_names[level] << " length " << n << std::endl;
+            }
+        }
+
+        std::size_t calls = std::max<std::size_t>(1, (1 << 24) / n);
+        auto per_call_ns = [&](double ms){ return ms * 1e6 / calls; };
+        auto row = [&](const std::string &name, double ms) {
+            std::cout << std::left << std::setw(32) << name + "/" + std::to_string(n) << std::right << std::fixed
+                      << std::setprecision(1) << std::setw(12) << per_call_ns(ms) << " ns" << std::endl;
+        };
+
+        row("argmin/PCB loop", best_ms(3, [&]{
+            for(std::size_t c = 0; c < calls; c++) {
+                std::size_t best = 0;
+                for(std::size_t i = 1; i < pcbs.size(); i++) {
+                    if(pcbs[i].PID < pcbs[best].PID) {
+                        best = i;
+                    }
+                }
+                bench_sink = best;
+            }
+        }));
+        for(int level = SIMD_SCALAR; level <= supported; level++) {
+            argmin_i32_kernel kernel = argmin_i32_for((simd_levels)level);
+            row(std::string("argmin/") + level_names[level], best_ms(3, [&]{
+                for(std::size_t c = 0; c < calls; c++) {
+                    bench_sink = kernel(keys.data(), n);
+                }
+            }));
+        }
+
+    }
+}
+
+void print_usage(const char *program) {
+    std::cout << "To run the program, do: " << program
+              << " [number_of_lines] [--processes 10,1000,100000] [--repetitions 3] [--seed 1] [--kernels]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+
+    std::size_t lines = 1000000;
+    std::vector<unsigned int> sizes = {10, 1000, 100000};
+    unsigned int repetitions = 3;
+    std::uint64_t seed = 1;
+    bool kernels_only = false;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if(arg == "--processes" && has_value) {
+            if(!parse_number_list(argv[++i], sizes)) {
+                print_usage(argv[0]);
+                return -1;
+            }
+        } else if(arg == "--repetitions" && has_value) {
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if(arg == "--seed" && has_value) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if(arg == "--kernels") {
+            kernels_only = true;
+        } else if(arg.rfind("--", 0) != 0) {
+            lines = std::stoul(arg);
+        } else {
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if(kernels_only) {
+        bench_kernels(seed);
+        return 0;
+    }
+
+    bench_parse(lines);
+    std::cout << std::endl;
+    bench_simulate(sizes, repetitions, seed);
+    bench_cpu_bound(repetitions, seed);
+    std::cout << std::endl;
+    bench_allocations(sizes, seed);
+
+    return 0;
+}
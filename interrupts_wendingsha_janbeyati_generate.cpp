@@ -0,0 +1,80 @@
+/**
+ * @file interrupts_wendingsha_janbeyati_generate.cpp
+ * @author wendingsha
+ * @brief Writes a synthetic input file (see generate_workload in the include file)
+ *
+ */
+
+#include "interrupts_wendingsha_janbeyati.hpp"
+
+void print_usage(const char *program) {
+    std::cout << "To run the program, do: " << program << " <number_of_processes> [output_file.txt] [--seed N]"
+              << " [--arrival exp:5] [--burst uniform:1:200] [--io-freq uniform:0:50]"
+              << " [--io-duration uniform:1:20] [--size uniform:1:40]" << std::endl;
+    std::cout << "Distributions: const:A, uniform:A:B, exp:MEAN, normal:MEAN:DEVIATION" << std::endl;
+}
+
+int main(int argc, char** argv) {
+
+    workload_spec spec;
+    std::string output_file = "workload.txt";
+    int positional = 0;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        distribution *field = nullptr;
+        if(arg == "--arrival") {
+            field = &spec.interarrival;
+        } else if(arg == "--burst") {
+            field = &spec.burst;
+        } else if(arg == "--io-freq") {
+            field = &spec.io_freq;
+        } else if(arg == "--io-duration") {
+            field = &spec.io_duration;
+        } else if(arg == "--size") {
+            field = &spec.size;
+        }
+
+        if(field && has_value) {
+            std::string error;
+            if(!parse_distribution(argv[++i], *field, error)) {
+                std::cout << "ERROR!\n" << error << std::endl;
+                print_usage(argv[0]);
+                return -1;
+            }
+        } else if(arg == "--seed" && has_value) {
+            spec.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if(arg.rfind("--", 0) != 0 && positional == 0) {
+            char *end = nullptr;
+            spec.processes = std::strtoull(arg.c_str(), &end, 10);
+            if(arg.empty() || *end != '\0') {
+                std::cout << "ERROR!\nBad number of processes " << arg << std::endl;
+                print_usage(argv[0]);
+                return -1;
+            }
+            positional++;
+        } else if(arg.rfind("--", 0) != 0 && positional == 1) {
+            output_file = arg;
+            positional++;
+        } else {
+            std::cout << "ERROR!\nUnexpected argument " << arg << std::endl;
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if(positional == 0) {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    std::vector<PCB> processes = generate_workload(spec);
+    if(!write_workload(processes, output_file.c_str())) {
+        std::cerr << "Error writing " << output_file << std::endl;
+        return -1;
+    }
+    std::cout << processes.size() << " processes written to " << output_file << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file interrupts_wendingsha_janbeyati_trace2txt.cpp
+ * @author wendingsha
+ * @brief Converts a binary trace (written with --binary) back into the execution table
+ *
+ */
+
+#include "interrupts_wendingsha_janbeyati.hpp"
+
+int main(int argc, char** argv) {
+
+    if(argc < 2 || argc > 3) {
+        std::cout << "To run the program, do: " << argv[0] << " <execution.bin> [output_file.txt]" << std::endl;
+        return -1;
+    }
+
+    const char *output_name = argc == 3 ? argv[2] : "execution.txt";
+
+    //Map the binary trace
+    binary_trace_reader records;
+    std::string error;
+    if (!records.open(argv[1], error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return -1;
+    }
+
+    //Write the same table the simulator writes in text mode
+    trace_writer trace;
+    if (!trace.open(output_name)) {
+        std::cerr << "Error opening file!" << std::endl;
+        return -1;
+    }
+
+    trace.cpu_column = records.has_cpu;
+    trace.write_header();
+    for (std::size_t i = 0; i < records.size(); i++) {
+        trace_record r = records[i];
+        if (r.old_state > NOT_ASSIGNED || r.new_state > NOT_ASSIGNED) {
+            std::cerr << "Error: record " << i << " has an unknown state" << std::endl;
+            return -1;
+        }
+        trace.write_status(r.time, r.PID, r.old_state, r.new_state, r.cpu);
+    }
+    trace.write_footer();
+
+    if (!trace.close()) {
+        std::cerr << "Error writing file!" << std::endl;
+        return -1;
+    }
+    std::cout << "Converted " << records.size() << " transitions into " << output_name << std::endl;
+
+    return 0;
+}